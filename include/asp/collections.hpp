@@ -1,4 +1,6 @@
 #pragma once
 
 #include "collections/SmallVec.hpp"
-#include "collections/Cache.hpp"
\ No newline at end of file
+#include "collections/Cache.hpp"
+#include "collections/DaryHeap.hpp"
+#include "collections/HashMap.hpp"
@@ -0,0 +1,123 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <utility>
+#include <stddef.h>
+
+namespace asp {
+
+/// A priority queue backed by an implicit d-ary heap stored in a contiguous vector.
+/// Compared to a binary heap, all children of a node share one or two cache lines, and the tree is shallower,
+/// which makes pushes cheaper and pops touch less memory.
+/// Like `std::priority_queue`, with the default `std::less` comparator the greatest element is at the top.
+template <typename T, size_t D = 4, typename Compare = std::less<T>>
+class DaryHeap {
+    static_assert(D >= 2, "DaryHeap arity must be at least 2");
+
+public:
+    DaryHeap() = default;
+    DaryHeap(Compare cmp) : m_cmp(std::move(cmp)) {}
+
+    bool empty() const noexcept {
+        return m_data.empty();
+    }
+
+    size_t size() const noexcept {
+        return m_data.size();
+    }
+
+    void reserve(size_t n) {
+        m_data.reserve(n);
+    }
+
+    void clear() noexcept {
+        m_data.clear();
+    }
+
+    /// Returns the element at the top of the heap. The heap must not be empty.
+    const T& top() const noexcept {
+        return m_data.front();
+    }
+
+    void push(const T& value) {
+        m_data.push_back(value);
+        this->siftUp(m_data.size() - 1);
+    }
+
+    void push(T&& value) {
+        m_data.push_back(std::move(value));
+        this->siftUp(m_data.size() - 1);
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        m_data.emplace_back(std::forward<Args>(args)...);
+        this->siftUp(m_data.size() - 1);
+    }
+
+    /// Removes and returns the element at the top of the heap. The heap must not be empty.
+    T pop() {
+        T out = std::move(m_data.front());
+
+        if (m_data.size() > 1) {
+            m_data.front() = std::move(m_data.back());
+            m_data.pop_back();
+            this->siftDown(0);
+        } else {
+            m_data.pop_back();
+        }
+
+        return out;
+    }
+
+    /// Returns the underlying storage, in heap order.
+    const std::vector<T>& data() const noexcept {
+        return m_data;
+    }
+
+private:
+    std::vector<T> m_data;
+    [[no_unique_address]] Compare m_cmp;
+
+    void siftUp(size_t idx) {
+        T value = std::move(m_data[idx]);
+
+        while (idx > 0) {
+            size_t parent = (idx - 1) / D;
+            if (!m_cmp(m_data[parent], value)) break;
+
+            m_data[idx] = std::move(m_data[parent]);
+            idx = parent;
+        }
+
+        m_data[idx] = std::move(value);
+    }
+
+    void siftDown(size_t idx) {
+        size_t count = m_data.size();
+        T value = std::move(m_data[idx]);
+
+        while (true) {
+            size_t first = idx * D + 1;
+            if (first >= count) break;
+
+            size_t last = first + D < count ? first + D : count;
+            size_t best = first;
+
+            for (size_t child = first + 1; child < last; child++) {
+                if (m_cmp(m_data[best], m_data[child])) {
+                    best = child;
+                }
+            }
+
+            if (!m_cmp(value, m_data[best])) break;
+
+            m_data[idx] = std::move(m_data[best]);
+            idx = best;
+        }
+
+        m_data[idx] = std::move(value);
+    }
+};
+
+}
@@ -0,0 +1,807 @@
+#pragma once
+#include <asp/detail/config.hpp>
+#include <asp/data/nums.hpp>
+#include <asp/simd/Group.hpp>
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace asp {
+
+/// A transparent hasher for string-like keys, so that a map keyed by `std::string` or `BoxedString` can be queried with a `std::string_view`.
+/// Keys that cache their hash (like `BoxedString` and `Symbol`) provide it through `hash()`, which must be the hash of their view.
+struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view str) const noexcept {
+        return std::hash<std::string_view>{}(str);
+    }
+
+    template <typename S> requires std::is_convertible_v<const S&, std::string_view> && requires (const S& s) {
+        { s.hash() } -> std::convertible_to<size_t>;
+    }
+    size_t operator()(const S& str) const noexcept {
+        return str.hash();
+    }
+};
+
+/// The hasher used by `HashMap` and `HashSet` unless specified otherwise.
+template <typename K>
+using DefaultHash = std::conditional_t<std::is_convertible_v<const K&, std::string_view>, StringHash, std::hash<K>>;
+
+namespace detail {
+
+// a full slot has the low 7 bits of its hash in its control byte, all other states have the highest bit set
+inline constexpr u8 CTRL_EMPTY = 0x80;
+inline constexpr u8 CTRL_DELETED = 0xfe;
+// pads the cloned control bytes of tables smaller than a group, never matches anything
+inline constexpr u8 CTRL_SENTINEL = 0xff;
+
+// std::hash of integers is usually the identity, spread the entropy over all bits before splitting the hash
+inline size_t mixHash(size_t hash) noexcept {
+#ifdef ASP_IS_64BIT
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+#else
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+#endif
+    return hash;
+}
+
+/// The open addressing table behind `HashMap` and `HashSet`, in the style of Abseil's Swiss tables.
+///
+/// Every slot has a control byte, which holds 7 bits of the hash of a full slot. Lookups compare a whole group of control bytes at once
+/// (see `asp::simd::Group`), and only compare keys of slots whose control byte matches. The first `Group::WIDTH` control bytes
+/// are cloned at the end of the array, so that a group can be loaded at any position without wrapping around.
+/// The capacity is always a power of two, and the table is kept at most 7/8 full.
+template <typename Slot, typename KeyOf, typename Hash, typename Eq>
+class RawHashTable {
+public:
+    using Group = simd::Group;
+
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
+    static constexpr size_t MIN_CAPACITY = 4;
+    static constexpr bool IS_TRANSPARENT = requires {
+        typename Hash::is_transparent;
+        typename Eq::is_transparent;
+    };
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Slot;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const Slot*, Slot*>;
+        using reference = std::conditional_t<Const, const Slot&, Slot&>;
+
+        Iterator() noexcept = default;
+
+        // a non-const iterator converts to a const one
+        template <bool C> requires (Const && !C)
+        Iterator(const Iterator<C>& other) noexcept
+            : m_ctrl(other.m_ctrl), m_slot(other.m_slot), m_end(other.m_end) {}
+
+        reference operator*() const noexcept {
+            return *m_slot;
+        }
+
+        pointer operator->() const noexcept {
+            return m_slot;
+        }
+
+        Iterator& operator++() noexcept {
+            ++m_ctrl;
+            ++m_slot;
+            this->skipEmpty();
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const Iterator& other) const noexcept {
+            return m_ctrl == other.m_ctrl;
+        }
+
+    private:
+        friend class RawHashTable;
+        friend class Iterator<!Const>;
+
+        const u8* m_ctrl = nullptr;
+        Slot* m_slot = nullptr;
+        const u8* m_end = nullptr;
+
+        Iterator(const u8* ctrl, Slot* slot, const u8* end) noexcept : m_ctrl(ctrl), m_slot(slot), m_end(end) {
+            this->skipEmpty();
+        }
+
+        void skipEmpty() noexcept {
+            while (m_ctrl != m_end && (*m_ctrl & 0x80)) {
+                ++m_ctrl;
+                ++m_slot;
+            }
+        }
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    RawHashTable() noexcept = default;
+
+    RawHashTable(const RawHashTable& other) : m_hash(other.m_hash), m_eq(other.m_eq) {
+        this->reserve(other.m_size);
+
+        for (auto& slot : other) {
+            this->insertUnique(slot);
+        }
+    }
+
+    RawHashTable& operator=(const RawHashTable& other) {
+        if (this != &other) {
+            auto copy = other;
+            this->swap(copy);
+        }
+        return *this;
+    }
+
+    RawHashTable(RawHashTable&& other) noexcept
+        : m_ctrl(std::exchange(other.m_ctrl, nullptr)),
+          m_slots(std::exchange(other.m_slots, nullptr)),
+          m_capacity(std::exchange(other.m_capacity, 0)),
+          m_size(std::exchange(other.m_size, 0)),
+          m_growthLeft(std::exchange(other.m_growthLeft, 0)),
+          m_hash(std::move(other.m_hash)),
+          m_eq(std::move(other.m_eq)) {}
+
+    RawHashTable& operator=(RawHashTable&& other) noexcept {
+        if (this != &other) {
+            this->destroyAll();
+            this->deallocate();
+
+            m_ctrl = std::exchange(other.m_ctrl, nullptr);
+            m_slots = std::exchange(other.m_slots, nullptr);
+            m_capacity = std::exchange(other.m_capacity, 0);
+            m_size = std::exchange(other.m_size, 0);
+            m_growthLeft = std::exchange(other.m_growthLeft, 0);
+            m_hash = std::move(other.m_hash);
+            m_eq = std::move(other.m_eq);
+        }
+        return *this;
+    }
+
+    ~RawHashTable() {
+        this->destroyAll();
+        this->deallocate();
+    }
+
+    void swap(RawHashTable& other) noexcept {
+        std::swap(m_ctrl, other.m_ctrl);
+        std::swap(m_slots, other.m_slots);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_size, other.m_size);
+        std::swap(m_growthLeft, other.m_growthLeft);
+        std::swap(m_hash, other.m_hash);
+        std::swap(m_eq, other.m_eq);
+    }
+
+    size_t size() const noexcept {
+        return m_size;
+    }
+
+    bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    /// Returns the amount of slots, the table rehashes once it is 7/8 full.
+    size_t capacity() const noexcept {
+        return m_capacity;
+    }
+
+    iterator begin() noexcept {
+        return iterator{m_ctrl, m_slots, m_ctrl + m_capacity};
+    }
+
+    iterator end() noexcept {
+        return iterator{m_ctrl + m_capacity, m_slots + m_capacity, m_ctrl + m_capacity};
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator{m_ctrl, m_slots, m_ctrl + m_capacity};
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator{m_ctrl + m_capacity, m_slots + m_capacity, m_ctrl + m_capacity};
+    }
+
+    /// Destroys all elements, but keeps the allocated capacity.
+    void clear() noexcept {
+        this->destroyAll();
+
+        if (m_capacity) {
+            this->resetCtrl();
+        }
+    }
+
+    /// Makes room for at least `count` elements without rehashing.
+    void reserve(size_t count) {
+        size_t capacity = capacityFor(count);
+        if (capacity > m_capacity) {
+            this->resize(capacity);
+        }
+    }
+
+    /// Reduces the capacity to the smallest one that fits the current elements, freeing the table entirely if it's empty.
+    void shrink() {
+        if (m_size == 0) {
+            this->deallocate();
+            return;
+        }
+
+        size_t capacity = capacityFor(m_size);
+        if (capacity < m_capacity) {
+            this->resize(capacity);
+        }
+    }
+
+protected:
+    u8* m_ctrl = nullptr;
+    Slot* m_slots = nullptr;
+    size_t m_capacity = 0;
+    size_t m_size = 0;
+    size_t m_growthLeft = 0;
+    [[no_unique_address]] Hash m_hash{};
+    [[no_unique_address]] Eq m_eq{};
+
+    template <typename Q>
+    size_t hashOf(const Q& key) const noexcept {
+        return mixHash(m_hash(key));
+    }
+
+    /// Returns the index of the slot holding `key`, or `NPOS`.
+    template <typename Q>
+    size_t findIndex(const Q& key) const {
+        if (!m_capacity) return NPOS;
+
+        return this->findIndex(key, this->hashOf(key));
+    }
+
+    /// Like `findIndex(key)`, for callers that already hashed the key.
+    template <typename Q>
+    size_t findIndex(const Q& key, size_t hash) const {
+        if (!m_capacity) return NPOS;
+
+        u8 h2 = hash & 0x7f;
+        size_t mask = m_capacity - 1;
+        size_t pos = (hash >> 7) & mask;
+        size_t stride = 0;
+
+        while (true) {
+            Group group{m_ctrl + pos};
+
+            for (auto match = group.match(h2); match; match.clearLowest()) {
+                size_t index = (pos + match.lowest()) & mask;
+                if (m_eq(KeyOf::key(m_slots[index]), key)) [[likely]] {
+                    return index;
+                }
+            }
+
+            if (group.match(CTRL_EMPTY)) {
+                return NPOS;
+            }
+
+            stride += Group::WIDTH;
+            pos = (pos + stride) & mask;
+        }
+    }
+
+    /// Finds `key`, or claims a slot for it. Returns the index and whether the key was found.
+    /// If it wasn't, the caller must construct an element in the slot before anything else is done with the table.
+    template <typename Q>
+    std::pair<size_t, bool> findOrPrepareInsert(const Q& key) {
+        size_t hash = this->hashOf(key);
+        size_t index = this->findIndex(key, hash);
+        if (index != NPOS) {
+            return {index, true};
+        }
+
+        return {this->prepareInsert(hash), false};
+    }
+
+    size_t prepareInsert(size_t hash) {
+        size_t index = m_capacity ? this->findFirstNonFull(hash) : NPOS;
+
+        // reusing a deleted slot doesn't use up any growth
+        if (m_growthLeft == 0 && (index == NPOS || m_ctrl[index] != CTRL_DELETED)) {
+            this->rehashForInsert();
+            index = this->findFirstNonFull(hash);
+        }
+
+        m_growthLeft -= m_ctrl[index] == CTRL_EMPTY;
+        this->setCtrl(index, hash & 0x7f);
+        m_size++;
+
+        return index;
+    }
+
+    /// Undoes `prepareInsert` if constructing the element threw.
+    void abortInsert(size_t index) noexcept {
+        this->eraseCtrl(index);
+    }
+
+    template <typename... Args>
+    size_t emplaceAt(size_t index, Args&&... args) {
+        try {
+            new (&m_slots[index]) Slot(std::forward<Args>(args)...);
+        } catch (...) {
+            this->abortInsert(index);
+            throw;
+        }
+
+        return index;
+    }
+
+    void insertUnique(const Slot& slot) {
+        size_t index = this->prepareInsert(this->hashOf(KeyOf::key(slot)));
+        this->emplaceAt(index, slot);
+    }
+
+    void eraseAt(size_t index) noexcept {
+        m_slots[index].~Slot();
+        this->eraseCtrl(index);
+    }
+
+    iterator iteratorAt(size_t index) noexcept {
+        if (index == NPOS) return this->end();
+        return iterator{m_ctrl + index, m_slots + index, m_ctrl + m_capacity};
+    }
+
+    const_iterator iteratorAt(size_t index) const noexcept {
+        if (index == NPOS) return this->end();
+        return const_iterator{m_ctrl + index, m_slots + index, m_ctrl + m_capacity};
+    }
+
+    size_t indexOf(const_iterator it) const noexcept {
+        return static_cast<size_t>(it.m_ctrl - m_ctrl);
+    }
+
+private:
+    static constexpr size_t SLOT_ALIGN = std::max(alignof(Slot), alignof(std::max_align_t));
+
+    static size_t growthFor(size_t capacity) noexcept {
+        // small tables must always keep one empty slot, so that probing for a missing key terminates
+        return capacity < 8 ? capacity - 1 : capacity - capacity / 8;
+    }
+
+    static size_t capacityFor(size_t count) noexcept {
+        if (count == 0) return 0;
+
+        size_t capacity = MIN_CAPACITY;
+        while (growthFor(capacity) < count) {
+            capacity *= 2;
+        }
+
+        return capacity;
+    }
+
+    static size_t slotsOffset(size_t capacity) noexcept {
+        size_t ctrlSize = capacity + Group::WIDTH;
+        return (ctrlSize + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+    }
+
+    size_t findFirstNonFull(size_t hash) const noexcept {
+        size_t mask = m_capacity - 1;
+        size_t pos = (hash >> 7) & mask;
+        size_t stride = 0;
+
+        while (true) {
+            Group group{m_ctrl + pos};
+
+            for (auto match = group.matchHighBit(); match; match.clearLowest()) {
+                size_t offset = match.lowest();
+                if (m_ctrl[pos + offset] != CTRL_SENTINEL) {
+                    return (pos + offset) & mask;
+                }
+            }
+
+            stride += Group::WIDTH;
+            pos = (pos + stride) & mask;
+        }
+    }
+
+    void setCtrl(size_t index, u8 value) noexcept {
+        m_ctrl[index] = value;
+
+        // keep the clone of the first group in sync
+        if (index < Group::WIDTH) {
+            m_ctrl[m_capacity + index] = value;
+        }
+    }
+
+    void eraseCtrl(size_t index) noexcept {
+        m_size--;
+
+        // if no probe sequence could have gone past this slot while it was full, it can simply become empty again.
+        // that is the case when the group windows around it have an empty slot close enough to it
+        bool wasNeverFull = m_capacity <= Group::WIDTH;
+
+        if (!wasNeverFull) {
+            size_t before = (index - Group::WIDTH) & (m_capacity - 1);
+            auto emptyBefore = Group{m_ctrl + before}.match(CTRL_EMPTY);
+            auto emptyAfter = Group{m_ctrl + index}.match(CTRL_EMPTY);
+
+            wasNeverFull = emptyBefore && emptyAfter && emptyAfter.trailingZeros() + emptyBefore.leadingZeros() < Group::WIDTH;
+        }
+
+        this->setCtrl(index, wasNeverFull ? CTRL_EMPTY : CTRL_DELETED);
+        m_growthLeft += wasNeverFull;
+    }
+
+    void resetCtrl() noexcept {
+        std::fill_n(m_ctrl, m_capacity, CTRL_EMPTY);
+
+        for (size_t i = 0; i < Group::WIDTH; i++) {
+            m_ctrl[m_capacity + i] = i < m_capacity ? CTRL_EMPTY : CTRL_SENTINEL;
+        }
+
+        m_growthLeft = growthFor(m_capacity);
+    }
+
+    void rehashForInsert() {
+        // lots of deleted slots, clean them up without growing
+        if (m_capacity > Group::WIDTH && m_size * 32 <= m_capacity * 25) {
+            this->resize(m_capacity);
+        } else {
+            this->resize(m_capacity ? m_capacity * 2 : MIN_CAPACITY);
+        }
+    }
+
+    void resize(size_t capacity) {
+        u8* oldCtrl = m_ctrl;
+        Slot* oldSlots = m_slots;
+        size_t oldCapacity = m_capacity;
+
+        auto mem = static_cast<u8*>(::operator new(slotsOffset(capacity) + sizeof(Slot) * capacity, std::align_val_t{SLOT_ALIGN}));
+        m_ctrl = mem;
+        m_slots = reinterpret_cast<Slot*>(mem + slotsOffset(capacity));
+        m_capacity = capacity;
+        this->resetCtrl();
+
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldCtrl[i] & 0x80) continue;
+
+            auto& slot = oldSlots[i];
+            size_t hash = this->hashOf(KeyOf::key(slot));
+            size_t index = this->findFirstNonFull(hash);
+            this->setCtrl(index, hash & 0x7f);
+
+            KeyOf::relocate(&m_slots[index], &slot);
+        }
+
+        m_growthLeft -= m_size;
+
+        if (oldCtrl) {
+            ::operator delete(oldCtrl, std::align_val_t{SLOT_ALIGN});
+        }
+    }
+
+    void destroyAll() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<Slot>) {
+            for (size_t i = 0; i < m_capacity; i++) {
+                if (!(m_ctrl[i] & 0x80)) {
+                    m_slots[i].~Slot();
+                }
+            }
+        }
+
+        m_size = 0;
+    }
+
+    void deallocate() noexcept {
+        if (m_ctrl) {
+            ::operator delete(m_ctrl, std::align_val_t{SLOT_ALIGN});
+        }
+
+        m_ctrl = nullptr;
+        m_slots = nullptr;
+        m_capacity = 0;
+        m_growthLeft = 0;
+    }
+};
+
+template <typename K, typename V>
+struct MapKeyOf {
+    using Slot = std::pair<const K, V>;
+
+    static const K& key(const Slot& slot) noexcept {
+        return slot.first;
+    }
+
+    static void relocate(Slot* dst, Slot* src) {
+        // the key is only const for users of the map, the table may move it out of a slot that is about to be destroyed
+        new (dst) Slot(std::piecewise_construct,
+            std::forward_as_tuple(std::move(const_cast<K&>(src->first))),
+            std::forward_as_tuple(std::move(src->second)));
+        src->~Slot();
+    }
+};
+
+template <typename K>
+struct SetKeyOf {
+    static const K& key(const K& slot) noexcept {
+        return slot;
+    }
+
+    static void relocate(K* dst, K* src) {
+        new (dst) K(std::move(*src));
+        src->~K();
+    }
+};
+
+}
+
+/// An open addressing hash map, with SIMD-probed control bytes (see `detail::RawHashTable`).
+/// Lookups into small and medium maps typically touch a single cache line of control bytes and one slot.
+/// Unlike `std::unordered_map`, inserting or rehashing moves elements, and invalidates references and iterators to them.
+///
+/// With the default hasher, maps with string-like keys (`std::string`, `BoxedString`, `Symbol`) can be queried
+/// with a `std::string_view` or anything else that converts to one, without constructing a key.
+template <typename K, typename V, typename Hash = DefaultHash<K>, typename Eq = std::equal_to<>>
+class HashMap : public detail::RawHashTable<std::pair<const K, V>, detail::MapKeyOf<K, V>, Hash, Eq> {
+    using Base = detail::RawHashTable<std::pair<const K, V>, detail::MapKeyOf<K, V>, Hash, Eq>;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using iterator = typename Base::iterator;
+    using const_iterator = typename Base::const_iterator;
+
+    /// A key type that lookups accept: anything that hashes and compares like `K` if the hasher is transparent, otherwise anything that converts to `K`.
+    template <typename Q>
+    static constexpr bool IS_KEY = Base::IS_TRANSPARENT || std::is_convertible_v<const Q&, const K&>;
+
+    HashMap() = default;
+
+    HashMap(std::initializer_list<value_type> list) {
+        this->reserve(list.size());
+        for (auto& item : list) {
+            this->insert(item);
+        }
+    }
+
+    template <typename Q> requires IS_KEY<Q>
+    iterator find(const Q& key) {
+        return this->iteratorAt(this->findIndex(this->lookupKey(key)));
+    }
+
+    template <typename Q> requires IS_KEY<Q>
+    const_iterator find(const Q& key) const {
+        return this->iteratorAt(this->findIndex(this->lookupKey(key)));
+    }
+
+    template <typename Q> requires IS_KEY<Q>
+    bool contains(const Q& key) const {
+        return this->findIndex(this->lookupKey(key)) != Base::NPOS;
+    }
+
+    /// Returns the value at the given key, or null if not present.
+    template <typename Q> requires IS_KEY<Q>
+    V* get(const Q& key) {
+        size_t index = this->findIndex(this->lookupKey(key));
+        return index == Base::NPOS ? nullptr : &this->m_slots[index].second;
+    }
+
+    template <typename Q> requires IS_KEY<Q>
+    const V* get(const Q& key) const {
+        size_t index = this->findIndex(this->lookupKey(key));
+        return index == Base::NPOS ? nullptr : &this->m_slots[index].second;
+    }
+
+    /// Inserts a value constructed from `args` if `key` is not present. Returns an iterator to the element and whether it was inserted.
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+        return this->tryEmplaceImpl(key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        return this->tryEmplaceImpl(std::move(key), std::forward<Args>(args)...);
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value) {
+        return this->try_emplace(value.first, value.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value) {
+        return this->try_emplace(value.first, std::move(value.second));
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        return this->insert(value_type(std::forward<Args>(args)...));
+    }
+
+    /// Inserts `value` at `key`, or assigns it if the key is already present.
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const K& key, M&& value) {
+        return this->insertOrAssignImpl(key, std::forward<M>(value));
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(K&& key, M&& value) {
+        return this->insertOrAssignImpl(std::move(key), std::forward<M>(value));
+    }
+
+    V& operator[](const K& key) {
+        return this->try_emplace(key).first->second;
+    }
+
+    V& operator[](K&& key) {
+        return this->try_emplace(std::move(key)).first->second;
+    }
+
+    /// Removes the element at `key`, returns whether it was present.
+    template <typename Q> requires IS_KEY<Q>
+    bool erase(const Q& key) {
+        size_t index = this->findIndex(this->lookupKey(key));
+        if (index == Base::NPOS) return false;
+
+        this->eraseAt(index);
+        return true;
+    }
+
+    /// Removes the element at `it`, and returns an iterator to the next one. Other iterators stay valid.
+    iterator erase(const_iterator it) {
+        size_t index = this->indexOf(it);
+        this->eraseAt(index);
+        return this->iteratorAt(index + 1);
+    }
+
+    iterator erase(iterator it) {
+        return this->erase(const_iterator{it});
+    }
+
+private:
+    template <typename Q>
+    static decltype(auto) lookupKey(const Q& key) {
+        if constexpr (Base::IS_TRANSPARENT || std::is_same_v<Q, K>) {
+            return (key);
+        } else {
+            return K(key);
+        }
+    }
+
+    template <typename KArg, typename... Args>
+    std::pair<iterator, bool> tryEmplaceImpl(KArg&& key, Args&&... args) {
+        auto [index, found] = this->findOrPrepareInsert(key);
+
+        if (!found) {
+            this->emplaceAt(index, std::piecewise_construct,
+                std::forward_as_tuple(std::forward<KArg>(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        return {this->iteratorAt(index), !found};
+    }
+
+    template <typename KArg, typename M>
+    std::pair<iterator, bool> insertOrAssignImpl(KArg&& key, M&& value) {
+        auto [index, found] = this->findOrPrepareInsert(key);
+
+        if (found) {
+            this->m_slots[index].second = std::forward<M>(value);
+        } else {
+            this->emplaceAt(index, std::forward<KArg>(key), std::forward<M>(value));
+        }
+
+        return {this->iteratorAt(index), !found};
+    }
+};
+
+/// An open addressing hash set, see `HashMap`.
+template <typename K, typename Hash = DefaultHash<K>, typename Eq = std::equal_to<>>
+class HashSet : public detail::RawHashTable<K, detail::SetKeyOf<K>, Hash, Eq> {
+    using Base = detail::RawHashTable<K, detail::SetKeyOf<K>, Hash, Eq>;
+
+public:
+    using key_type = K;
+    using value_type = K;
+    using iterator = typename Base::const_iterator;
+    using const_iterator = typename Base::const_iterator;
+
+    template <typename Q>
+    static constexpr bool IS_KEY = Base::IS_TRANSPARENT || std::is_convertible_v<const Q&, const K&>;
+
+    HashSet() = default;
+
+    HashSet(std::initializer_list<K> list) {
+        this->reserve(list.size());
+        for (auto& item : list) {
+            this->insert(item);
+        }
+    }
+
+    // elements are immutable, since changing them would change their hash
+    const_iterator begin() const noexcept {
+        return Base::begin();
+    }
+
+    const_iterator end() const noexcept {
+        return Base::end();
+    }
+
+    template <typename Q> requires IS_KEY<Q>
+    const_iterator find(const Q& key) const {
+        return this->iteratorAt(this->findIndex(this->lookupKey(key)));
+    }
+
+    template <typename Q> requires IS_KEY<Q>
+    bool contains(const Q& key) const {
+        return this->findIndex(this->lookupKey(key)) != Base::NPOS;
+    }
+
+    std::pair<const_iterator, bool> insert(const K& key) {
+        return this->insertImpl(key);
+    }
+
+    std::pair<const_iterator, bool> insert(K&& key) {
+        return this->insertImpl(std::move(key));
+    }
+
+    template <typename... Args>
+    std::pair<const_iterator, bool> emplace(Args&&... args) {
+        return this->insertImpl(K(std::forward<Args>(args)...));
+    }
+
+    template <typename Q> requires IS_KEY<Q>
+    bool erase(const Q& key) {
+        size_t index = this->findIndex(this->lookupKey(key));
+        if (index == Base::NPOS) return false;
+
+        this->eraseAt(index);
+        return true;
+    }
+
+    const_iterator erase(const_iterator it) {
+        size_t index = this->indexOf(it);
+        this->eraseAt(index);
+        return std::as_const(*this).iteratorAt(index + 1);
+    }
+
+private:
+    template <typename Q>
+    static decltype(auto) lookupKey(const Q& key) {
+        if constexpr (Base::IS_TRANSPARENT || std::is_same_v<Q, K>) {
+            return (key);
+        } else {
+            return K(key);
+        }
+    }
+
+    template <typename KArg>
+    std::pair<const_iterator, bool> insertImpl(KArg&& key) {
+        auto [index, found] = this->findOrPrepareInsert(key);
+
+        if (!found) {
+            this->emplaceAt(index, std::forward<KArg>(key));
+        }
+
+        return {std::as_const(*this).iteratorAt(index), !found};
+    }
+};
+
+}
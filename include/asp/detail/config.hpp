@@ -69,3 +69,11 @@ namespace asp::detail {
 # define ASP_NOINLINE __attribute__((noinline))
 # define ASP_COLD __attribute__((cold))
 #endif
+
+// Used for padding frequently written shared state, to avoid false sharing
+
+#if defined(__APPLE__) && defined(ASP_IS_ARM64)
+# define ASP_CACHE_LINE_SIZE 128
+#else
+# define ASP_CACHE_LINE_SIZE 64
+#endif
@@ -1,4 +1,7 @@
 #pragma once
 
 #include "ptr/SharedPtr.hpp"
-#include "ptr/PtrSwap.hpp"
\ No newline at end of file
+#include "ptr/IntrusivePtr.hpp"
+#include "ptr/PoolAllocator.hpp"
+#include "ptr/PtrSwap.hpp"
+#include "ptr/Rc.hpp"
\ No newline at end of file
@@ -2,7 +2,11 @@
 #include <asp/ptr/SharedPtr.hpp>
 #include <memory>
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
 #include <string_view>
 #include <fmt/format.h>
 
@@ -11,88 +15,182 @@ namespace asp {
 template <typename Derived, typename Base>
 struct BoxedStringImpl;
 
-struct BoxedStringImplUnique {
-    BoxedStringImplUnique() = default;
-    BoxedStringImplUnique(std::string_view str) {
-        if (str.empty()) return;
+namespace detail {
 
-        m_size = str.size();
-        m_data = std::make_unique<char[]>(m_size + 1);
-        std::copy(str.begin(), str.end(), m_data.get());
-        m_data[m_size] = '\0';
+/// Storage of a boxed string. Strings of up to `INLINE_CAPACITY` characters are stored inline, without allocating,
+/// longer ones are stored on the heap, either in a `SharedPtr` (shared between copies) or a `unique_ptr`.
+/// The hash of the string is computed lazily and cached in the object.
+template <bool Shared>
+class BoxedStringStorage {
+public:
+    static constexpr size_t INLINE_CAPACITY = 22;
+
+    BoxedStringStorage() noexcept {
+        m_storage[0] = '\0';
+        m_storage[TAG] = 0;
+    }
+
+    BoxedStringStorage(std::string_view str) {
+        char* data = this->init(str.size());
+        std::copy(str.begin(), str.end(), data);
+    }
+
+    BoxedStringStorage(const BoxedStringStorage& other) requires Shared : m_hash(other.m_hash.load(std::memory_order::relaxed)) {
+        this->copyFrom(other);
+    }
+
+    BoxedStringStorage& operator=(const BoxedStringStorage& other) requires Shared {
+        if (this != &other) {
+            this->destroy();
+            this->copyFrom(other);
+            m_hash.store(other.m_hash.load(std::memory_order::relaxed), std::memory_order::relaxed);
+        }
+        return *this;
+    }
+
+    BoxedStringStorage(BoxedStringStorage&& other) noexcept : m_hash(other.m_hash.load(std::memory_order::relaxed)) {
+        this->moveFrom(other);
     }
 
-    BoxedStringImplUnique(BoxedStringImplUnique&&) = default;
-    BoxedStringImplUnique& operator=(BoxedStringImplUnique&&) = default;
-    BoxedStringImplUnique(const BoxedStringImplUnique&) = delete;
-    BoxedStringImplUnique& operator=(const BoxedStringImplUnique&) = delete;
+    BoxedStringStorage& operator=(BoxedStringStorage&& other) noexcept {
+        if (this != &other) {
+            this->destroy();
+            this->moveFrom(other);
+            m_hash.store(other.m_hash.load(std::memory_order::relaxed), std::memory_order::relaxed);
+        }
+        return *this;
+    }
+
+    ~BoxedStringStorage() {
+        this->destroy();
+    }
 
     std::string_view view() const noexcept {
-        return std::string_view(m_data.get(), m_size);
+        if (this->isInline()) {
+            return std::string_view(reinterpret_cast<const char*>(m_storage), m_storage[TAG]);
+        } else {
+            return std::string_view(this->heap().get(), this->heapSize());
+        }
     }
 
     const char* c_str() const noexcept {
-        return m_data ? m_data.get() : "";
+        return this->isInline() ? reinterpret_cast<const char*>(m_storage) : this->heap().get();
     }
 
-private:
-    template <typename D, typename B>
-    friend struct BoxedStringImpl;
+    /// Returns whether the string is stored inline, without a heap allocation.
+    bool isInline() const noexcept {
+        return m_storage[TAG] != HEAP;
+    }
 
-    std::unique_ptr<char[]> m_data;
-    size_t m_size = 0;
+    /// Returns `std::hash<std::string_view>` of the string, computing it on the first call.
+    size_t hash() const noexcept {
+        size_t hash = m_hash.load(std::memory_order::relaxed);
 
-    BoxedStringImplUnique(size_t size) {
-        if (!size) return;
+        // a string that hashes to zero is simply rehashed every time
+        if (hash == 0) {
+            hash = std::hash<std::string_view>{}(this->view());
+            m_hash.store(hash, std::memory_order::relaxed);
+        }
 
-        m_size = size;
-        m_data = std::make_unique<char[]>(m_size + 1);
-        m_data[m_size] = '\0';
+        return hash;
     }
-};
 
-struct BoxedStringImplShared {
-    BoxedStringImplShared() = default;
-    BoxedStringImplShared(std::string_view str) {
-        if (str.empty()) return;
+private:
+    template <typename D, typename B>
+    friend struct asp::BoxedStringImpl;
+
+    using Heap = std::conditional_t<Shared, SharedPtr<char[]>, std::unique_ptr<char[]>>;
 
-        auto size = str.size();
-        m_data = asp::make_shared<char[]>(size + 1);
-        std::copy(str.begin(), str.end(), m_data.get());
-        m_data[size] = '\0';
+    static constexpr size_t TAG = 23;
+    static constexpr unsigned char HEAP = 0xff;
+
+    // inline: the characters, a null terminator, and the length in the last byte.
+    // heap: the `Heap` pointer and the length, the last byte is `HEAP`
+    alignas(Heap) unsigned char m_storage[24];
+    mutable std::atomic<size_t> m_hash{0};
+
+    /// Sets up storage for `size` characters plus the null terminator, which is already written. Used by `format`.
+    BoxedStringStorage(size_t size) {
+        this->init(size);
     }
 
-    std::string_view view() const noexcept {
-        if (m_data) {
-            return std::string_view(m_data.get(), m_data.size() - 1);
+    char* init(size_t size) {
+        char* data;
+
+        if (size <= INLINE_CAPACITY) {
+            m_storage[TAG] = static_cast<unsigned char>(size);
+            data = reinterpret_cast<char*>(m_storage);
         } else {
-            return std::string_view();
+            Heap heap;
+            if constexpr (Shared) {
+                heap = asp::makeSharedForOverwrite<char[]>(size + 1);
+            } else {
+                heap = std::make_unique_for_overwrite<char[]>(size + 1);
+            }
+
+            data = heap.get();
+            new (m_storage) Heap(std::move(heap));
+            std::memcpy(m_storage + sizeof(Heap), &size, sizeof(size));
+            m_storage[TAG] = HEAP;
         }
+
+        data[size] = '\0';
+        return data;
     }
 
-    const char* c_str() const noexcept {
-        return m_data ? m_data.get() : "";
+    char* data() noexcept {
+        return this->isInline() ? reinterpret_cast<char*>(m_storage) : this->heap().get();
     }
 
-    BoxedStringImplShared(BoxedStringImplShared&&) = default;
-    BoxedStringImplShared& operator=(BoxedStringImplShared&&) = default;
-    BoxedStringImplShared(const BoxedStringImplShared&) = default;
-    BoxedStringImplShared& operator=(const BoxedStringImplShared&) = default;
+    Heap& heap() noexcept {
+        return *std::launder(reinterpret_cast<Heap*>(m_storage));
+    }
 
-private:
-    template <typename D, typename B>
-    friend struct BoxedStringImpl;
+    const Heap& heap() const noexcept {
+        return *std::launder(reinterpret_cast<const Heap*>(m_storage));
+    }
 
-    asp::SharedPtr<char[]> m_data;
+    size_t heapSize() const noexcept {
+        size_t size;
+        std::memcpy(&size, m_storage + sizeof(Heap), sizeof(size));
+        return size;
+    }
+
+    void copyFrom(const BoxedStringStorage& other) {
+        std::memcpy(m_storage, other.m_storage, sizeof(m_storage));
 
-    BoxedStringImplShared(size_t size) {
-        if (!size) return;
+        if (!other.isInline()) {
+            new (m_storage) Heap(other.heap());
+        }
+    }
+
+    void moveFrom(BoxedStringStorage& other) noexcept {
+        std::memcpy(m_storage, other.m_storage, sizeof(m_storage));
+
+        if (!other.isInline()) {
+            new (m_storage) Heap(std::move(other.heap()));
+            other.heap().~Heap();
+        }
 
-        m_data = asp::make_shared<char[]>(size + 1);
-        m_data.get()[size] = '\0';
+        other.m_storage[0] = '\0';
+        other.m_storage[TAG] = 0;
+        other.m_hash.store(0, std::memory_order::relaxed);
+    }
+
+    void destroy() noexcept {
+        if (!this->isInline()) {
+            this->heap().~Heap();
+        }
     }
 };
 
+}
+
+/// A heap string that is shared between copies, copying it never copies the characters.
+using BoxedStringImplShared = detail::BoxedStringStorage<true>;
+/// A heap string that is owned by a single object.
+using BoxedStringImplUnique = detail::BoxedStringStorage<false>;
+
 template <typename Derived, typename Base>
 struct BoxedStringImpl : Base {
     using Base::Base;
@@ -138,8 +236,10 @@ struct BoxedStringImpl : Base {
     template <typename... Args>
     static Derived format(fmt::format_string<Args...> fmt, Args&&... args) {
         size_t size = fmt::formatted_size(fmt, std::forward<Args>(args)...);
+
+        // short results are formatted right into the inline storage
         Derived result(size);
-        char* ptr = result.m_data.get();
+        char* ptr = result.data();
 
         auto formattedSize = fmt::format_to_n(ptr, size, fmt, std::forward<Args>(args)...).size;
         if (formattedSize < size) {
@@ -169,4 +269,18 @@ struct UniqueBoxedString : BoxedStringImpl<UniqueBoxedString, BoxedStringImplUni
     }
 };
 
-}
\ No newline at end of file
+}
+
+template <>
+struct std::hash<asp::BoxedString> {
+    size_t operator()(const asp::BoxedString& s) const noexcept {
+        return s.hash();
+    }
+};
+
+template <>
+struct std::hash<asp::UniqueBoxedString> {
+    size_t operator()(const asp::UniqueBoxedString& s) const noexcept {
+        return s.hash();
+    }
+};
\ No newline at end of file
@@ -0,0 +1,221 @@
+#pragma once
+#include "PtrSwap.hpp"
+#include <asp/detail/config.hpp>
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+namespace asp {
+
+template <typename T>
+class IntrusivePtr;
+
+namespace refcount {
+    /// The count is updated with atomic operations, objects can be shared between threads.
+    struct Atomic {};
+    /// The count is a plain integer, objects must stay on one thread.
+    struct Local {};
+}
+
+/// Base class for objects managed by `IntrusivePtr`. The reference count is stored inside the object,
+/// so there is no separate control block, no weak count and no type-erased destructor. `T` is the class that is deleted
+/// when the count drops to zero, usually the derived class itself (or a base with a virtual destructor).
+/// Copying an object does not copy its count.
+template <typename T, typename Policy = refcount::Atomic>
+class RefCounted {
+public:
+    size_t refCount() const noexcept {
+        if constexpr (IS_ATOMIC) {
+            return m_refs.load(std::memory_order::relaxed);
+        } else {
+            return m_refs;
+        }
+    }
+
+protected:
+    RefCounted() noexcept = default;
+    RefCounted(const RefCounted&) noexcept {}
+    RefCounted& operator=(const RefCounted&) noexcept { return *this; }
+    ~RefCounted() = default;
+
+private:
+    template <typename U>
+    friend class IntrusivePtr;
+    template <typename P>
+    friend struct detail::PtrSwapTraits;
+
+    static constexpr bool IS_ATOMIC = std::is_same_v<Policy, refcount::Atomic>;
+
+    mutable std::conditional_t<IS_ATOMIC, std::atomic<size_t>, size_t> m_refs{0};
+
+    void retain() const noexcept {
+        if constexpr (IS_ATOMIC) {
+            m_refs.fetch_add(1, std::memory_order::relaxed);
+        } else {
+            m_refs++;
+        }
+    }
+
+    void unretain() const noexcept {
+        if constexpr (IS_ATOMIC) {
+            m_refs.fetch_sub(1, std::memory_order::relaxed);
+        } else {
+            m_refs--;
+        }
+    }
+
+    void release() const noexcept {
+        if constexpr (IS_ATOMIC) {
+            if (m_refs.fetch_sub(1, std::memory_order::release) == 1) [[unlikely]] {
+                std::atomic_thread_fence(std::memory_order::acquire);
+                delete static_cast<const T*>(this);
+            }
+        } else {
+            if (--m_refs == 0) [[unlikely]] {
+                delete static_cast<const T*>(this);
+            }
+        }
+    }
+};
+
+/// A smart pointer to an object that derives from `RefCounted`, which stores the reference count inside the object.
+/// It is the size of a raw pointer, and a raw pointer to a managed object can be turned back into an `IntrusivePtr` at any time.
+template <typename T>
+class IntrusivePtr {
+public:
+    IntrusivePtr() noexcept : m_ptr(nullptr) {}
+    IntrusivePtr(std::nullptr_t) noexcept : m_ptr(nullptr) {}
+
+    /// Takes a new reference to `ptr`, which must be managed by `IntrusivePtr`s (or freshly created with `new`).
+    explicit IntrusivePtr(T* ptr) noexcept : m_ptr(ptr) {
+        if (m_ptr) m_ptr->retain();
+    }
+
+    /// Wraps `ptr` without taking a new reference, the counterpart of `leak`.
+    static IntrusivePtr adoptFromRaw(T* ptr) noexcept {
+        IntrusivePtr out;
+        out.m_ptr = ptr;
+        return out;
+    }
+
+    IntrusivePtr(const IntrusivePtr& other) noexcept : IntrusivePtr(other.m_ptr) {}
+
+    IntrusivePtr& operator=(const IntrusivePtr& other) noexcept {
+        if (this != &other) {
+            if (other.m_ptr) other.m_ptr->retain();
+            this->release();
+            m_ptr = other.m_ptr;
+        }
+        return *this;
+    }
+
+    IntrusivePtr(IntrusivePtr&& other) noexcept : m_ptr(std::exchange(other.m_ptr, nullptr)) {}
+
+    IntrusivePtr& operator=(IntrusivePtr&& other) noexcept {
+        if (this != &other) {
+            this->release();
+            m_ptr = std::exchange(other.m_ptr, nullptr);
+        }
+        return *this;
+    }
+
+    template <typename Y> requires std::is_convertible_v<Y*, T*>
+    IntrusivePtr(const IntrusivePtr<Y>& other) noexcept : IntrusivePtr(static_cast<T*>(other.get())) {}
+
+    template <typename Y> requires std::is_convertible_v<Y*, T*>
+    IntrusivePtr(IntrusivePtr<Y>&& other) noexcept : m_ptr(other.get()) {
+        other.leak();
+    }
+
+    ~IntrusivePtr() {
+        this->release();
+    }
+
+    size_t refCount() const noexcept {
+        return m_ptr ? m_ptr->refCount() : 0;
+    }
+
+    T* get() const noexcept {
+        return m_ptr;
+    }
+
+    T& operator*() const noexcept {
+        return *m_ptr;
+    }
+
+    T* operator->() const noexcept {
+        return m_ptr;
+    }
+
+    operator bool() const noexcept {
+        return m_ptr != nullptr;
+    }
+
+    bool operator==(std::nullptr_t) const noexcept {
+        return m_ptr == nullptr;
+    }
+
+    bool operator==(const IntrusivePtr& other) const noexcept {
+        return m_ptr == other.m_ptr;
+    }
+
+    /// Gives up the reference without releasing it, see `adoptFromRaw`.
+    void leak() noexcept {
+        m_ptr = nullptr;
+    }
+
+    void reset() {
+        this->release();
+        m_ptr = nullptr;
+    }
+
+private:
+    T* m_ptr;
+
+    void release() {
+        if (m_ptr) m_ptr->release();
+    }
+};
+
+template <typename T, typename... Args>
+IntrusivePtr<T> makeIntrusive(Args&&... args) {
+    return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+namespace detail {
+
+template <typename T>
+struct PtrSwapTraits<IntrusivePtr<T>> {
+    using Element = T;
+
+    static size_t toRaw(const IntrusivePtr<T>& ptr) noexcept {
+        return reinterpret_cast<size_t>(ptr.get());
+    }
+
+    static IntrusivePtr<T> adopt(size_t raw) noexcept {
+        return IntrusivePtr<T>::adoptFromRaw(reinterpret_cast<T*>(raw));
+    }
+
+    static T* get(size_t raw) noexcept {
+        return reinterpret_cast<T*>(raw);
+    }
+
+    static void retain(size_t raw) noexcept {
+        requireAtomic(reinterpret_cast<T*>(raw));
+        reinterpret_cast<T*>(raw)->retain();
+    }
+
+    static void unretain(size_t raw) noexcept {
+        reinterpret_cast<T*>(raw)->unretain();
+    }
+
+private:
+    template <typename U, typename Policy>
+    static void requireAtomic(const RefCounted<U, Policy>*) noexcept {
+        static_assert(std::is_same_v<Policy, refcount::Atomic>, "PtrSwap requires an atomic reference count");
+    }
+};
+
+}
+
+}
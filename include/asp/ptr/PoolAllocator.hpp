@@ -0,0 +1,116 @@
+#pragma once
+#include "SharedPtr.hpp"
+#include <asp/detail/config.hpp>
+#include <algorithm>
+#include <new>
+
+namespace asp {
+
+namespace detail {
+
+/// A per-thread cache of freed memory chunks of one size and alignment.
+template <size_t Size, size_t Align>
+class PoolCache {
+public:
+    static constexpr size_t CAPACITY = 64;
+
+    static PoolCache& local() noexcept {
+        static thread_local PoolCache cache;
+        return cache;
+    }
+
+    void* allocate() {
+        if (m_head) {
+            auto node = m_head;
+            m_head = node->next;
+            m_count--;
+            return node;
+        }
+
+        return ::operator new(CHUNK, std::align_val_t{Align});
+    }
+
+    void deallocate(void* ptr) noexcept {
+        if (m_count >= CAPACITY) {
+            ::operator delete(ptr, std::align_val_t{Align});
+            return;
+        }
+
+        auto node = static_cast<Node*>(ptr);
+        node->next = m_head;
+        m_head = node;
+        m_count++;
+    }
+
+    ~PoolCache() {
+        while (m_head) {
+            auto node = m_head;
+            m_head = node->next;
+            ::operator delete(node, std::align_val_t{Align});
+        }
+
+        // objects freed later on this thread (from other thread-local destructors) bypass the cache
+        m_count = CAPACITY;
+    }
+
+private:
+    struct Node {
+        Node* next;
+    };
+
+    static constexpr size_t CHUNK = std::max(Size, sizeof(Node));
+
+    Node* m_head = nullptr;
+    size_t m_count = 0;
+};
+
+}
+
+/// A standard allocator that keeps a small per-thread free list for every object size, so that objects which are
+/// created and destroyed all the time (like per-message `SharedPtr`s) are recycled instead of going through `malloc`.
+/// Memory freed on another thread goes into that thread's cache. Only single-object allocations are cached.
+template <typename T>
+struct PoolAllocator {
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n != 1) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+        }
+
+        return static_cast<T*>(cache().allocate());
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        if (n != 1) {
+            ::operator delete(ptr, std::align_val_t{alignof(T)});
+            return;
+        }
+
+        cache().deallocate(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept {
+        return true;
+    }
+
+private:
+    // only named inside member functions, `T` may still be incomplete when the allocator type is formed
+    static auto& cache() noexcept {
+        return detail::PoolCache<sizeof(T), alignof(T)>::local();
+    }
+};
+
+/// Like `make_shared`, but the control block comes from a `PoolAllocator`.
+template <typename T, typename... Args>
+SharedPtr<T> makeSharedPooled(Args&&... args) {
+    return allocateShared<T>(PoolAllocator<T>{}, std::forward<Args>(args)...);
+}
+
+}
@@ -4,27 +4,163 @@
 
 namespace asp {
 
+namespace detail {
+
+/// Hazard slots ("debts") of the calling thread, used by `PtrSwap` to read the current pointer without touching its refcount.
+/// A slot holding a pointer tells writers that the thread is using that object without owning a reference to it.
+struct DebtSlots {
+    static constexpr size_t FAST = 8;
+
+    /// Held by `PtrSwap::Guard`s for as long as they live.
+    std::atomic<size_t> fast[FAST];
+    /// Held only for the duration of `PtrSwap::load`.
+    std::atomic<size_t> fallback;
+};
+
+DebtSlots& localDebtSlots() noexcept;
+
+/// Must be called by a writer after it has unpublished `raw`, while still holding a reference to it.
+/// Every thread that has a debt on `raw` is given a reference of its own through `retain`, and its slot is cleared.
+/// `unretain` drops a reference that turned out not to be needed, it is never the last one.
+void payDebts(size_t raw, void(*retain)(size_t), void(*unretain)(size_t)) noexcept;
+
+/// How `PtrSwap` stores a smart pointer as a single word. The pointer's refcount must be atomic.
+template <typename Ptr>
+struct PtrSwapTraits;
+
 template <typename T>
+struct PtrSwapTraits<SharedPtr<T>> {
+    using Element = T;
+
+    static size_t toRaw(const SharedPtr<T>& ptr) noexcept {
+        return reinterpret_cast<size_t>(ptr.m_block);
+    }
+
+    static SharedPtr<T> adopt(size_t raw) noexcept {
+        return SharedPtr<T>::adoptFromRaw(reinterpret_cast<SharedPtrBlock<T>*>(raw));
+    }
+
+    static T* get(size_t raw) noexcept {
+        return reinterpret_cast<SharedPtrBlock<T>*>(raw)->ptr();
+    }
+
+    static void retain(size_t raw) noexcept {
+        reinterpret_cast<SharedPtrBlockBase*>(raw)->retainStrong();
+    }
+
+    static void unretain(size_t raw) noexcept {
+        // never the last reference, see `payDebts`
+        auto block = reinterpret_cast<SharedPtrBlockBase*>(raw);
+        if (!block->ops->biased) {
+            block->strong.fetch_sub(1, std::memory_order::relaxed);
+        } else {
+            block->releaseStrong();
+        }
+    }
+};
+
+}
+
+/// An atomic `SharedPtr`, for data that is read very often and replaced rarely, like configuration snapshots.
+/// `PtrSwap<T, IntrusivePtr<T>>` does the same for intrusively counted objects.
+///
+/// Readers don't lock anything. `load` costs a single refcount increment, while `loadGuard` borrows the current value
+/// by storing it in one of the calling thread's hazard slots, so it doesn't write to any shared memory at all in the common case.
+/// Writers check those slots when replacing the value, and hand a proper reference to any reader that is still using the old one.
+template <typename T, typename P>
 class PtrSwap {
 public:
-    using Ptr = SharedPtr<T>;
-    using Block = SharedPtrBlock<T>;
+    using Ptr = P;
+    using Traits = detail::PtrSwapTraits<P>;
+
+    /// A borrowed reference to the value of a `PtrSwap`, keeps it alive even if it is replaced in the meantime.
+    /// Keep guards short-lived, each thread only has a few hazard slots, after that `loadGuard` falls back to a full `load`.
+    class Guard {
+    public:
+        Guard() noexcept = default;
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        Guard(Guard&& other) noexcept
+            : m_raw(std::exchange(other.m_raw, 0)), m_slot(std::exchange(other.m_slot, nullptr)) {}
+
+        Guard& operator=(Guard&& other) noexcept {
+            if (this != &other) {
+                this->release();
+                m_raw = std::exchange(other.m_raw, 0);
+                m_slot = std::exchange(other.m_slot, nullptr);
+            }
+            return *this;
+        }
+
+        ~Guard() {
+            this->release();
+        }
+
+        T* get() const noexcept {
+            return m_raw ? Traits::get(m_raw) : nullptr;
+        }
+
+        T& operator*() const noexcept {
+            return *Traits::get(m_raw);
+        }
+
+        T* operator->() const noexcept {
+            return Traits::get(m_raw);
+        }
+
+        explicit operator bool() const noexcept {
+            return m_raw != 0;
+        }
+
+        /// Returns a new reference to the guarded value, that can outlive the guard.
+        Ptr toShared() const noexcept {
+            if (!m_raw) return Ptr{};
+
+            Traits::retain(m_raw);
+            return Traits::adopt(m_raw);
+        }
+
+    private:
+        friend class PtrSwap;
+
+        size_t m_raw = 0;
+        // the hazard slot holding our debt, or null if we own a reference instead
+        std::atomic<size_t>* m_slot = nullptr;
+
+        Guard(size_t raw, std::atomic<size_t>* slot) noexcept : m_raw(raw), m_slot(slot) {}
+
+        void release() noexcept {
+            if (!m_raw) return;
+
+            size_t expected = m_raw;
+
+            // if a writer paid our debt in the meantime, we own a reference that has to be released
+            if (!m_slot || !m_slot->compare_exchange_strong(expected, 0, std::memory_order::seq_cst)) {
+                auto _ = Traits::adopt(m_raw);
+            }
+
+            m_raw = 0;
+            m_slot = nullptr;
+        }
+    };
 
     PtrSwap() {}
     PtrSwap(std::nullptr_t) : PtrSwap() {}
 
-    PtrSwap(const SharedPtr<T>& ptr) {
+    PtrSwap(const Ptr& ptr) {
         this->store(ptr);
     }
 
     PtrSwap(const PtrSwap&) = delete;
     PtrSwap& operator=(const PtrSwap&) = delete;
-    PtrSwap(PtrSwap&& other) noexcept : m_block(other.m_block.load(std::memory_order::relaxed)) {}
+    PtrSwap(PtrSwap&& other) noexcept : m_raw(other.m_raw.exchange(0, std::memory_order::relaxed)) {}
 
     PtrSwap& operator=(PtrSwap&& other) noexcept {
         if (this != &other) {
             this->release();
-            m_block.store(other.m_block.load(std::memory_order::relaxed), std::memory_order::relaxed);
+            m_raw.store(other.m_raw.exchange(0, std::memory_order::relaxed), std::memory_order::relaxed);
         }
         return *this;
     }
@@ -33,8 +169,68 @@ public:
         this->release();
     }
 
+    /// Returns a new reference to the current value.
     Ptr load() const {
-        return Ptr{this->block<true>()};
+        auto& slot = detail::localDebtSlots().fallback;
+
+        while (true) {
+            size_t raw = m_raw.load(std::memory_order::acquire);
+            if (!raw) return Ptr{};
+
+            // announce that we are about to use the object, then make sure it wasn't replaced (and possibly freed) before that
+            slot.store(raw, std::memory_order::seq_cst);
+
+            if (m_raw.load(std::memory_order::seq_cst) == raw) {
+                Traits::retain(raw);
+
+                size_t expected = raw;
+                if (!slot.compare_exchange_strong(expected, 0, std::memory_order::seq_cst)) {
+                    // a writer has paid our debt while we were taking our own reference, drop the extra one
+                    Traits::unretain(raw);
+                }
+
+                return Traits::adopt(raw);
+            }
+
+            size_t expected = raw;
+            if (!slot.compare_exchange_strong(expected, 0, std::memory_order::seq_cst)) {
+                // too late, but the writer gave us a reference to the old value
+                return Traits::adopt(raw);
+            }
+        }
+    }
+
+    /// Borrows the current value without touching its refcount, see `Guard`.
+    Guard loadGuard() const {
+        auto& slots = detail::localDebtSlots();
+
+        for (auto& slot : slots.fast) {
+            // only this thread ever stores a nonzero value, so a zero can't change under us
+            if (slot.load(std::memory_order::relaxed) != 0) continue;
+
+            while (true) {
+                size_t raw = m_raw.load(std::memory_order::acquire);
+                if (!raw) return Guard{};
+
+                slot.store(raw, std::memory_order::seq_cst);
+
+                if (m_raw.load(std::memory_order::seq_cst) == raw) {
+                    return Guard{raw, &slot};
+                }
+
+                size_t expected = raw;
+                if (!slot.compare_exchange_strong(expected, 0, std::memory_order::seq_cst)) {
+                    return Guard{raw, nullptr};
+                }
+            }
+        }
+
+        // all slots are taken, fall back to a real reference
+        auto ptr = this->load();
+        size_t raw = Traits::toRaw(ptr);
+        ptr.leak();
+
+        return Guard{raw, nullptr};
     }
 
     void store(const Ptr& ptr) {
@@ -46,39 +242,38 @@ public:
     }
 
     Ptr swap(const Ptr& ptr) {
-        size_t newB = reinterpret_cast<size_t>(ptr.m_block);
-        size_t oldB = m_block.exchange(newB, std::memory_order::seq_cst);
-        this->retain(ptr);
+        size_t newRaw = Traits::toRaw(ptr);
+        if (newRaw) Traits::retain(newRaw);
 
-        return Ptr::adoptFromRaw(reinterpret_cast<Block*>(oldB));
+        return this->replace(newRaw);
     }
 
     Ptr swap(Ptr&& ptr) {
-        size_t newB = reinterpret_cast<size_t>(ptr.m_block);
-        size_t oldB = m_block.exchange(newB, std::memory_order::seq_cst);
+        size_t newRaw = Traits::toRaw(ptr);
 
         // skip the retain and just null out the moved-from ptr
         ptr.leak();
 
-        return Ptr::adoptFromRaw(reinterpret_cast<Block*>(oldB));
+        return this->replace(newRaw);
     }
 
     /// Performs an atomic Read-Copy-Update operation. The provided function may be called multiple times, with the current value (const Ptr&),
-    /// and is expected to return a new SharedPtr to store.
+    /// and is expected to return a new pointer to store.
     Ptr rcu(auto&& f) noexcept requires (std::is_invocable_r_v<Ptr, decltype(f), const Ptr&>) {
         Ptr oldPtr = this->load();
 
         while (true) {
             auto newPtr = f(oldPtr);
 
-            auto oldBlock = reinterpret_cast<size_t>(oldPtr.m_block);
-            auto newBlock = reinterpret_cast<size_t>(newPtr.m_block);
+            auto oldRaw = Traits::toRaw(oldPtr);
+            auto newRaw = Traits::toRaw(newPtr);
 
-            if (m_block.compare_exchange_weak(oldBlock, newBlock, std::memory_order::acq_rel, std::memory_order::acquire)) {
-                this->retain(newPtr);
+            if (m_raw.compare_exchange_weak(oldRaw, newRaw, std::memory_order::acq_rel, std::memory_order::acquire)) {
+                if (newRaw) Traits::retain(newRaw);
+                this->payDebts(oldRaw);
 
                 // need to release the old ptr twice (once for the load and once for the swap)
-                auto _ = Ptr::adoptFromRaw(reinterpret_cast<Block*>(oldBlock));
+                auto _ = Traits::adopt(oldRaw);
 
                 return newPtr;
             }
@@ -89,25 +284,27 @@ public:
     }
 
 private:
-    std::atomic<size_t> m_block{0};
+    std::atomic<size_t> m_raw{0};
 
-    template <bool Acquire = true>
-    Block* block() const {
-        return reinterpret_cast<Block*>(m_block.load(
-            Acquire ? std::memory_order::acquire : std::memory_order::relaxed
-        ));
+    Ptr replace(size_t newRaw) {
+        size_t oldRaw = m_raw.exchange(newRaw, std::memory_order::seq_cst);
+        this->payDebts(oldRaw);
+
+        return Traits::adopt(oldRaw);
     }
 
     void release() {
-        // we just let SharedPtr handle this
-        auto _ = Ptr::adoptFromRaw(this->block<false>());
+        size_t raw = m_raw.exchange(0, std::memory_order::seq_cst);
+        this->payDebts(raw);
+
+        auto _ = Traits::adopt(raw);
     }
 
-    void retain(const Ptr& ptr) {
-        if (ptr.m_block) {
-            ptr.m_block->strong.fetch_add(1, std::memory_order::relaxed);
+    static void payDebts(size_t raw) noexcept {
+        if (raw) {
+            detail::payDebts(raw, &Traits::retain, &Traits::unretain);
         }
     }
 };
 
-}
\ No newline at end of file
+}
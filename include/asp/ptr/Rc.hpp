@@ -0,0 +1,291 @@
+#pragma once
+#include "SharedPtr.hpp"
+#include <asp/detail/config.hpp>
+
+#ifdef ASP_DEBUG
+# include <thread>
+#endif
+
+namespace asp {
+
+template <typename T>
+class Weak;
+
+/// A single-threaded version of `SharedPtr`, for object graphs that never leave the thread that created them.
+/// It uses the same `SharedPtrBlock` layout, but the reference counts are updated with plain loads and stores instead of atomic read-modify-writes.
+///
+/// An `Rc` and everything copied from it must only be used on the thread that created it, which is asserted in debug builds.
+/// To hand the object to other threads, convert it with `intoShared`.
+template <typename T>
+class Rc {
+public:
+    Rc() noexcept : m_block(nullptr) {}
+    Rc(std::nullptr_t) noexcept : m_block(nullptr) {}
+
+    static Rc adoptFromRaw(SharedPtrBlock<T>* block) noexcept {
+        Rc ptr;
+        ptr.m_block = block;
+        return ptr;
+    }
+
+    Rc(const Rc& other) noexcept : m_block(other.m_block) {
+#ifdef ASP_DEBUG
+        m_owner = other.m_owner;
+#endif
+        if (m_block) this->retain();
+    }
+
+    Rc& operator=(const Rc& other) noexcept {
+        if (this != &other) {
+            this->release();
+            m_block = other.m_block;
+#ifdef ASP_DEBUG
+            m_owner = other.m_owner;
+#endif
+            if (m_block) this->retain();
+        }
+        return *this;
+    }
+
+    Rc(Rc&& other) noexcept : m_block(std::exchange(other.m_block, nullptr)) {
+#ifdef ASP_DEBUG
+        m_owner = other.m_owner;
+#endif
+    }
+
+    Rc& operator=(Rc&& other) noexcept {
+        if (this != &other) {
+            this->release();
+            m_block = std::exchange(other.m_block, nullptr);
+#ifdef ASP_DEBUG
+            m_owner = other.m_owner;
+#endif
+        }
+        return *this;
+    }
+
+    ~Rc() {
+        this->release();
+    }
+
+    size_t strongCount() const noexcept {
+        return m_block ? m_block->strong.load(std::memory_order::relaxed) : 0;
+    }
+
+    size_t weakCount() const noexcept {
+        return m_block ? m_block->weak.load(std::memory_order::relaxed) : 0;
+    }
+
+    T* get() const noexcept {
+        return m_block ? m_block->ptr() : nullptr;
+    }
+
+    T& operator*() const noexcept {
+        return *m_block->ptr();
+    }
+
+    T* operator->() const noexcept {
+        return m_block->ptr();
+    }
+
+    operator bool() const noexcept {
+        return m_block != nullptr;
+    }
+
+    bool operator==(std::nullptr_t) const noexcept {
+        return m_block == nullptr;
+    }
+
+    bool operator==(const Rc& other) const noexcept {
+        return m_block == other.m_block;
+    }
+
+    void reset() {
+        this->release();
+        m_block = nullptr;
+    }
+
+    /// Converts this into a thread-safe `SharedPtr` to the same object, without copying it.
+    /// This is only possible if this is the only reference to the object (no other `Rc`s or `Weak`s),
+    /// otherwise a null pointer is returned and this `Rc` is left untouched.
+    SharedPtr<T> intoShared() && {
+        if (!m_block) return {};
+        this->checkThread();
+
+        if (m_block->strong.load(std::memory_order::relaxed) != 1 || m_block->weak.load(std::memory_order::relaxed) != 1) {
+            return {};
+        }
+
+        return SharedPtr<T>::adoptFromRaw(std::exchange(m_block, nullptr));
+    }
+
+    template <typename Y>
+    operator Rc<Y>() const requires std::is_convertible_v<T*, Y*> {
+        SharedPtrBlockBase* base = m_block;
+        auto ptr = Rc<Y>::adoptFromRaw(reinterpret_cast<SharedPtrBlock<Y>*>(base));
+#ifdef ASP_DEBUG
+        ptr.m_owner = m_owner;
+#endif
+        if (m_block) ptr.retain();
+        return ptr;
+    }
+
+private:
+    template <typename U>
+    friend class Rc;
+    friend class Weak<T>;
+
+    SharedPtrBlock<T>* m_block;
+#ifdef ASP_DEBUG
+    std::thread::id m_owner = std::this_thread::get_id();
+#endif
+
+    void checkThread() const noexcept {
+#ifdef ASP_DEBUG
+        ASP_ALWAYS_ASSERT(m_owner == std::this_thread::get_id(), "asp::Rc used from a thread other than the one that created it");
+#endif
+    }
+
+    void retain() noexcept {
+        this->checkThread();
+        auto& strong = m_block->strong;
+        strong.store(strong.load(std::memory_order::relaxed) + 1, std::memory_order::relaxed);
+    }
+
+    void release();
+};
+
+template <typename T>
+class Weak {
+public:
+    Weak() : m_block(nullptr) {}
+    Weak(std::nullptr_t) : m_block(nullptr) {}
+
+    Weak(const Rc<T>& rc) : m_block(rc.m_block) {
+#ifdef ASP_DEBUG
+        m_owner = rc.m_owner;
+#endif
+        this->retain();
+    }
+
+    Weak(const Weak& other) : m_block(other.m_block) {
+#ifdef ASP_DEBUG
+        m_owner = other.m_owner;
+#endif
+        this->retain();
+    }
+
+    Weak& operator=(const Weak& other) {
+        if (this != &other) {
+            this->release();
+            m_block = other.m_block;
+#ifdef ASP_DEBUG
+            m_owner = other.m_owner;
+#endif
+            this->retain();
+        }
+        return *this;
+    }
+
+    Weak(Weak&& other) noexcept : m_block(std::exchange(other.m_block, nullptr)) {
+#ifdef ASP_DEBUG
+        m_owner = other.m_owner;
+#endif
+    }
+
+    Weak& operator=(Weak&& other) noexcept {
+        if (this != &other) {
+            this->release();
+            m_block = std::exchange(other.m_block, nullptr);
+#ifdef ASP_DEBUG
+            m_owner = other.m_owner;
+#endif
+        }
+        return *this;
+    }
+
+    ~Weak() {
+        this->release();
+    }
+
+    /// Returns a strong reference to the object, or a null `Rc` if it has already been destroyed.
+    Rc<T> upgrade() const {
+        if (this->expired()) return {};
+
+        auto rc = Rc<T>::adoptFromRaw(reinterpret_cast<SharedPtrBlock<T>*>(m_block));
+#ifdef ASP_DEBUG
+        rc.m_owner = m_owner;
+#endif
+        rc.retain();
+        return rc;
+    }
+
+    bool expired() const noexcept {
+        return !m_block || m_block->strong.load(std::memory_order::relaxed) == 0;
+    }
+
+private:
+    template <typename U>
+    friend class Rc;
+
+    SharedPtrBlockBase* m_block;
+#ifdef ASP_DEBUG
+    std::thread::id m_owner = std::this_thread::get_id();
+#endif
+
+    void retain() noexcept {
+        if (!m_block) return;
+
+#ifdef ASP_DEBUG
+        ASP_ALWAYS_ASSERT(m_owner == std::this_thread::get_id(), "asp::Weak used from a thread other than the one that created it");
+#endif
+        auto& weak = m_block->weak;
+        weak.store(weak.load(std::memory_order::relaxed) + 1, std::memory_order::relaxed);
+    }
+
+    void release();
+};
+
+template <typename T, typename... Args>
+Rc<T> make_rc(Args&&... args) {
+    return Rc<T>::adoptFromRaw(SharedPtrBlock<T>::create(std::forward<Args>(args)...));
+}
+
+template <typename T>
+void Rc<T>::release() {
+    if (!m_block) return;
+    this->checkThread();
+
+    auto& strong = m_block->strong;
+    size_t count = strong.load(std::memory_order::relaxed) - 1;
+    strong.store(count, std::memory_order::relaxed);
+
+    if (count == 0) [[unlikely]] {
+        // the strong references collectively hold one weak reference, which keeps the block alive during the destructor
+        auto weak = Weak<T>{};
+        weak.m_block = m_block;
+#ifdef ASP_DEBUG
+        weak.m_owner = m_owner;
+#endif
+        m_block->ops->destroy(m_block);
+    }
+}
+
+template <typename T>
+void Weak<T>::release() {
+    if (!m_block) return;
+
+#ifdef ASP_DEBUG
+    ASP_ALWAYS_ASSERT(m_owner == std::this_thread::get_id(), "asp::Weak used from a thread other than the one that created it");
+#endif
+
+    auto& weak = m_block->weak;
+    size_t count = weak.load(std::memory_order::relaxed) - 1;
+    weak.store(count, std::memory_order::relaxed);
+
+    if (count == 0) [[unlikely]] {
+        m_block->ops->deallocate(m_block);
+    }
+}
+
+}
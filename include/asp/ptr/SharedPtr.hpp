@@ -3,6 +3,7 @@
 #include <atomic>
 #include <utility>
 #include <memory>
+#include <ranges>
 
 namespace asp {
 
@@ -10,20 +11,138 @@ template <typename T>
 class WeakPtr;
 template <typename T>
 class SharedPtr;
-template <typename T>
+template <typename T, typename Ptr = SharedPtr<T>>
 class PtrSwap;
 
+namespace detail {
+    template <typename Ptr>
+    struct PtrSwapTraits;
+
+    struct BiasedOwner;
+
+    /// The owner record of the calling thread, null until it creates its first biased block (see `makeSharedBiased`).
+    inline thread_local BiasedOwner* t_biasedOwner = nullptr;
+}
+
 template <typename T, typename... Args>
 SharedPtr<T> make_shared(Args&&... args);
-
-using SharedPtrDtor = void(*)(void*);
+template <typename T, typename Alloc, typename... Args>
+SharedPtr<T> allocateShared(const Alloc& alloc, Args&&... args);
+template <typename T, typename... Args>
+SharedPtr<T> makeSharedBiased(Args&&... args);
+
+struct SharedPtrBlockBase;
+
+/// Type-erased operations of a control block, shared by all blocks of the same type.
+struct SharedPtrBlockOps {
+    /// Destroys the object, called when the strong count drops to zero.
+    void (*destroy)(SharedPtrBlockBase*);
+    /// Frees the block itself, called when the weak count drops to zero.
+    void (*deallocate)(SharedPtrBlockBase*);
+    /// Whether the block is preceded by a `SharedPtrBiasedState`, see `makeSharedBiased`.
+    bool biased = false;
+};
 
 struct SharedPtrBlockBase {
+    /// For biased blocks, this holds the references of all threads except the owner, see `SharedPtrBiasedState`.
     std::atomic<size_t> strong;
     std::atomic<size_t> weak;
-    SharedPtrDtor dtor;
+    const SharedPtrBlockOps* ops;
+
+    void retainStrong() noexcept;
+    /// Returns true if the strong count dropped to zero, the caller must then destroy the object.
+    bool releaseStrong() noexcept;
+    /// Takes a strong reference unless the object has already been destroyed.
+    bool tryRetainStrong() noexcept;
+    size_t strongCount() const noexcept;
 };
 
+/// Biased reference counting: the thread that created a block owns it, and counts its own references in `biased`
+/// with plain loads and stores, while all other threads use the atomic `strong` count of the block.
+///
+/// For biased blocks, `strong` holds a signed count shifted left by two bits, along with the `MERGED` and `QUEUED` flags.
+/// The count goes negative when another thread releases a reference that the owner counted. The first thread to notice
+/// that queues the block to the owner, which merges `biased` into `strong` (giving up the bias) the next time it touches
+/// its queue. The owner also merges as soon as its own count drops to zero. Only merged blocks can be destroyed.
+struct SharedPtrBiasedState {
+    static constexpr size_t MERGED = 1;
+    static constexpr size_t QUEUED = 2;
+    static constexpr size_t ONE = 4;
+
+    /// The owner thread, or null once the counts have been merged.
+    std::atomic<detail::BiasedOwner*> owner;
+    /// References counted by the owner. Other threads only read it, except when the owner has exited (under its lock).
+    std::atomic<size_t> biased;
+    /// Link in the owner's merge queue.
+    SharedPtrBlockBase* nextQueued;
+
+    static SharedPtrBiasedState* of(const SharedPtrBlockBase* block) noexcept {
+        return reinterpret_cast<SharedPtrBiasedState*>(const_cast<char*>(reinterpret_cast<const char*>(block)) - sizeof(SharedPtrBiasedState));
+    }
+
+    bool ownedByCurrentThread() const noexcept {
+        auto current = detail::t_biasedOwner;
+        return current && owner.load(std::memory_order::relaxed) == current;
+    }
+
+    static ptrdiff_t count(size_t strong) noexcept {
+        return static_cast<ptrdiff_t>(strong) >> 2;
+    }
+};
+
+namespace detail {
+    /// Returns the owner record of the calling thread, creating it if needed, and merges any blocks queued to it.
+    /// Returns null if the thread is exiting.
+    BiasedOwner* localBiasedOwner() noexcept;
+    /// Merges the blocks queued to the calling thread.
+    void drainBiasedQueue() noexcept;
+
+    // the biased paths live out of line, so the state preceding the block is never visible to the optimizer in user code
+    void biasedRetain(SharedPtrBlockBase* block) noexcept;
+    bool biasedRelease(SharedPtrBlockBase* block) noexcept;
+    bool biasedTryRetain(SharedPtrBlockBase* block) noexcept;
+    size_t biasedCount(const SharedPtrBlockBase* block) noexcept;
+}
+
+inline void SharedPtrBlockBase::retainStrong() noexcept {
+    if (!ops->biased) [[likely]] {
+        strong.fetch_add(1, std::memory_order::relaxed);
+    } else {
+        detail::biasedRetain(this);
+    }
+}
+
+inline bool SharedPtrBlockBase::releaseStrong() noexcept {
+    if (!ops->biased) [[likely]] {
+        return strong.fetch_sub(1, std::memory_order::release) == 1;
+    }
+
+    return detail::biasedRelease(this);
+}
+
+inline bool SharedPtrBlockBase::tryRetainStrong() noexcept {
+    if (ops->biased) {
+        return detail::biasedTryRetain(this);
+    }
+
+    size_t count = strong.load(std::memory_order::relaxed);
+    while (count != 0) {
+        if (strong.compare_exchange_weak(count, count + 1, std::memory_order::acquire, std::memory_order::relaxed)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline size_t SharedPtrBlockBase::strongCount() const noexcept {
+    if (ops->biased) {
+        return detail::biasedCount(this);
+    }
+
+    return strong.load(std::memory_order::relaxed);
+}
+
 template <typename T>
 struct SharedPtrBlock : SharedPtrBlockBase {
     T data;
@@ -38,10 +157,7 @@ struct SharedPtrBlock : SharedPtrBlockBase {
 
         mem->strong.store(1);
         mem->weak.store(1);
-        mem->dtor = [](void* ptr) {
-            auto block = reinterpret_cast<SharedPtrBlock*>(ptr);
-            block->data.~T();
-        };
+        mem->ops = &OPS;
         new (&mem->data) T(std::forward<Args>(args)...);
 
         return mem.release();
@@ -50,6 +166,15 @@ struct SharedPtrBlock : SharedPtrBlockBase {
     T* ptr() noexcept {
         return &data;
     }
+
+    static void destroyData(SharedPtrBlockBase* base) {
+        static_cast<SharedPtrBlock*>(base)->data.~T();
+    }
+
+    static constexpr SharedPtrBlockOps OPS = {
+        &destroyData,
+        +[](SharedPtrBlockBase* base) { ::operator delete(base); },
+    };
 };
 
 template <typename T>
@@ -57,7 +182,45 @@ struct SharedPtrBlock<T[]> : SharedPtrBlockBase {
     size_t size;
     T data[];
 
+    /// Value-initializes `size` elements.
     static SharedPtrBlock* create(size_t size) {
+        return createWith(size, [](T* elem) { new (elem) T(); });
+    }
+
+    /// Default-initializes `size` elements, which leaves them uninitialized for trivial types.
+    static SharedPtrBlock* createForOverwrite(size_t size) {
+        if constexpr (std::is_trivially_default_constructible_v<T>) {
+            return createWith(size, nullptr);
+        } else {
+            return createWith(size, [](T* elem) { new (elem) T; });
+        }
+    }
+
+    /// Constructs `size` elements in place from consecutive values of `it`.
+    template <typename It>
+    static SharedPtrBlock* createFromIterator(It it, size_t size) {
+        return createWith(size, [&](T* elem) {
+            new (elem) T(*it);
+            ++it;
+        });
+    }
+
+    T* ptr() noexcept {
+        return &data[0];
+    }
+
+    static constexpr SharedPtrBlockOps OPS = {
+        +[](SharedPtrBlockBase* base) {
+            auto block = static_cast<SharedPtrBlock*>(base);
+            std::destroy_n(block->data, block->size);
+        },
+        +[](SharedPtrBlockBase* base) { ::operator delete(base); },
+    };
+
+private:
+    // every element is constructed exactly once by `init(elem)`, or left uninitialized if `init` is null
+    template <typename F>
+    static SharedPtrBlock* createWith(size_t size, F&& init) {
         // wrap into unique_ptr for exception safety
         std::unique_ptr<SharedPtrBlock, void(*)(void*)> mem{
             reinterpret_cast<SharedPtrBlock*>(::operator new(sizeof(SharedPtrBlock) + sizeof(T) * size)),
@@ -66,25 +229,101 @@ struct SharedPtrBlock<T[]> : SharedPtrBlockBase {
 
         mem->strong.store(1);
         mem->weak.store(1);
-        mem->dtor = [](void* ptr) {
-            auto block = reinterpret_cast<SharedPtrBlock*>(ptr);
-            for (size_t i = 0; i < block->size; i++) {
-                block->data[i].~T();
-            }
-        };
+        mem->ops = &OPS;
         mem->size = size;
 
-        // default initialize `size` elements
-        for (size_t i = 0; i < size; i++) {
-            new (&mem->data[i]) T();
+        if constexpr (!std::is_null_pointer_v<std::remove_cvref_t<F>>) {
+            size_t i = 0;
+
+            try {
+                for (; i < size; i++) {
+                    init(&mem->data[i]);
+                }
+            } catch (...) {
+                std::destroy_n(mem->data, i);
+                throw;
+            }
         }
 
         return mem.release();
     }
+};
 
-    T* ptr() noexcept {
-        return &data[0];
+/// A control block that was allocated with a user-provided allocator, which it keeps a copy of to free itself later.
+template <typename T, typename Alloc>
+struct SharedPtrAllocBlock : SharedPtrBlock<T> {
+    using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<SharedPtrAllocBlock>;
+    using Traits = std::allocator_traits<BlockAlloc>;
+
+    [[no_unique_address]] BlockAlloc alloc;
+
+    template <typename... Args>
+    static SharedPtrAllocBlock* create(const Alloc& userAlloc, Args&&... args) {
+        BlockAlloc alloc{userAlloc};
+        auto mem = Traits::allocate(alloc, 1);
+
+        try {
+            new (&mem->data) T(std::forward<Args>(args)...);
+        } catch (...) {
+            Traits::deallocate(alloc, mem, 1);
+            throw;
+        }
+
+        mem->strong.store(1);
+        mem->weak.store(1);
+        mem->ops = &OPS;
+        new (&mem->alloc) BlockAlloc(std::move(alloc));
+
+        return mem;
+    }
+
+    static constexpr SharedPtrBlockOps OPS = {
+        &SharedPtrBlock<T>::destroyData,
+        +[](SharedPtrBlockBase* base) {
+            auto block = static_cast<SharedPtrAllocBlock*>(base);
+
+            // the allocator lives inside the block, move it out before freeing the memory
+            BlockAlloc alloc{std::move(block->alloc)};
+            block->alloc.~BlockAlloc();
+            Traits::deallocate(alloc, block, 1);
+        },
+    };
+};
+
+/// A block created by `makeSharedBiased`, which is preceded by its `SharedPtrBiasedState`.
+template <typename T>
+struct SharedPtrBiasedBlock {
+    static constexpr size_t OFFSET = (sizeof(SharedPtrBiasedState) + alignof(SharedPtrBlock<T>) - 1) / alignof(SharedPtrBlock<T>) * alignof(SharedPtrBlock<T>);
+
+    template <typename... Args>
+    static SharedPtrBlock<T>* create(detail::BiasedOwner* owner, Args&&... args) {
+        // wrap into unique_ptr for exception safety
+        std::unique_ptr<char, void(*)(void*)> mem{
+            static_cast<char*>(::operator new(OFFSET + sizeof(SharedPtrBlock<T>))),
+            +[](void* ptr) { ::operator delete(ptr); }
+        };
+
+        auto block = reinterpret_cast<SharedPtrBlock<T>*>(mem.get() + OFFSET);
+        new (&block->data) T(std::forward<Args>(args)...);
+
+        block->strong.store(0);
+        block->weak.store(1);
+        block->ops = &OPS;
+
+        auto state = new (mem.get() + OFFSET - sizeof(SharedPtrBiasedState)) SharedPtrBiasedState{};
+        state->owner.store(owner);
+        state->biased.store(1);
+        state->nextQueued = nullptr;
+
+        mem.release();
+        return block;
     }
+
+    static constexpr SharedPtrBlockOps OPS = {
+        &SharedPtrBlock<T>::destroyData,
+        +[](SharedPtrBlockBase* base) { ::operator delete(reinterpret_cast<char*>(base) - OFFSET); },
+        true,
+    };
 };
 
 template <typename T>
@@ -100,7 +339,7 @@ public:
     }
 
     SharedPtr(SharedPtrBlock<T>* block) noexcept : m_block(block) {
-        if (m_block) m_block->strong.fetch_add(1, std::memory_order::relaxed);
+        if (m_block) m_block->retainStrong();
     }
 
     SharedPtr(const SharedPtr& other) noexcept : SharedPtr(other.m_block) {}
@@ -109,7 +348,7 @@ public:
         if (this != &other) {
             this->release();
             m_block = other.m_block;
-            if (m_block) m_block->strong.fetch_add(1, std::memory_order::relaxed);
+            if (m_block) m_block->retainStrong();
         }
         return *this;
     }
@@ -129,7 +368,7 @@ public:
     }
 
     size_t strongCount() const noexcept {
-        return m_block ? m_block->strong.load(std::memory_order::relaxed) : 0;
+        return m_block ? m_block->strongCount() : 0;
     }
 
     size_t weakCount() const noexcept {
@@ -185,10 +424,14 @@ public:
 
 private:
     friend class WeakPtr<T>;
-    friend class PtrSwap<T>;
+    friend struct detail::PtrSwapTraits<SharedPtr<T>>;
 
     template <typename U, typename... Args>
     friend SharedPtr<U> make_shared(Args&&... args);
+    template <typename U, typename Alloc, typename... Args>
+    friend SharedPtr<U> allocateShared(const Alloc& alloc, Args&&... args);
+    template <typename U, typename... Args>
+    friend SharedPtr<U> makeSharedBiased(Args&&... args);
 
     SharedPtrBlock<T>* m_block;
 
@@ -241,20 +484,13 @@ public:
     }
 
     SharedPtr<T> upgrade() const {
-        if (!m_block) return SharedPtr<T>();
-
-        size_t strong = m_block->strong.load(std::memory_order::relaxed);
-        while (strong != 0) {
-            if (m_block->strong.compare_exchange_weak(strong, strong + 1, std::memory_order::acquire, std::memory_order::relaxed)) {
-                return SharedPtr<T>::adoptFromRaw(reinterpret_cast<SharedPtrBlock<T>*>(m_block));
-            }
-        }
+        if (!m_block || !m_block->tryRetainStrong()) return SharedPtr<T>();
 
-        return SharedPtr<T>();
+        return SharedPtr<T>::adoptFromRaw(reinterpret_cast<SharedPtrBlock<T>*>(m_block));
     }
 
     bool expired() const {
-        return !m_block || m_block->strong.load(std::memory_order::relaxed) == 0;
+        return !m_block || m_block->strongCount() == 0;
     }
 
 private:
@@ -279,12 +515,68 @@ SharedPtr<T> makeShared(Args&&... args) {
     return make_shared<T>(std::forward<Args>(args)...);
 }
 
+/// Creates a shared array of `size` default-initialized elements. For trivial types like `char` the memory is left uninitialized,
+/// which avoids writing a buffer twice when it is about to be filled anyway.
+template <typename T> requires std::is_unbounded_array_v<T>
+SharedPtr<T> makeSharedForOverwrite(size_t size) {
+    return SharedPtr<T>::adoptFromRaw(SharedPtrBlock<T>::createForOverwrite(size));
+}
+
+/// Creates a shared array of `size` elements, constructed in place from consecutive values of `it`.
+template <typename T, typename It> requires std::is_unbounded_array_v<T>
+SharedPtr<T> makeSharedFromIterator(It it, size_t size) {
+    return SharedPtr<T>::adoptFromRaw(SharedPtrBlock<T>::createFromIterator(std::move(it), size));
+}
+
+/// Creates a shared array with a copy of every element of `range`, each constructed in place exactly once.
+template <typename T, std::ranges::sized_range R> requires std::is_unbounded_array_v<T>
+SharedPtr<T> makeSharedFromRange(R&& range) {
+    return makeSharedFromIterator<T>(std::ranges::begin(range), std::ranges::size(range));
+}
+
+/// Like `make_shared`, but the control block is allocated with `alloc`, a standard allocator that is rebound to the block type.
+/// A copy of the allocator is stored in the block and used to free it once the last weak reference is gone.
+template <typename T, typename Alloc, typename... Args>
+SharedPtr<T> allocateShared(const Alloc& alloc, Args&&... args) {
+    static_assert(!std::is_array_v<T>, "allocateShared does not support arrays");
+
+    SharedPtrBlock<T>* block = SharedPtrAllocBlock<T, Alloc>::create(alloc, std::forward<Args>(args)...);
+    auto sp = SharedPtr<T>::adoptFromRaw(block);
+    sp._initSharedFromThis(sp.get());
+    return sp;
+}
+
+/// Like `make_shared`, but the object is biased towards the calling thread: copying and releasing pointers to it
+/// on this thread is done without atomic operations, while other threads pay a bit more, as the counts have to be merged
+/// once a reference crosses threads. Good for objects that are mostly used by the thread that created them.
+///
+/// Blocks that need a merge are queued to their owner thread, which processes the queue whenever it creates another biased object,
+/// drops its last own reference to one, calls `mergeBiasedRefcounts`, or exits. Until then, such objects stay alive.
+template <typename T, typename... Args>
+SharedPtr<T> makeSharedBiased(Args&&... args) {
+    static_assert(!std::is_array_v<T>, "makeSharedBiased does not support arrays");
+
+    auto owner = detail::localBiasedOwner();
+    if (!owner) [[unlikely]] {
+        return make_shared<T>(std::forward<Args>(args)...);
+    }
+
+    auto sp = SharedPtr<T>::adoptFromRaw(SharedPtrBiasedBlock<T>::create(owner, std::forward<Args>(args)...));
+    sp._initSharedFromThis(sp.get());
+    return sp;
+}
+
+/// Merges the counts of biased objects owned by this thread that were released by other threads, see `makeSharedBiased`.
+/// Threads that create biased objects and then only rarely touch them again can call this periodically, so that such objects are freed in time.
+inline void mergeBiasedRefcounts() noexcept {
+    detail::drainBiasedQueue();
+}
 
 template <typename T>
 void SharedPtr<T>::release() {
     if (!m_block) return;
 
-    if (m_block->strong.fetch_sub(1, std::memory_order::release) == 1) [[unlikely]] {
+    if (m_block->releaseStrong()) [[unlikely]] {
         this->destroyData();
     }
 }
@@ -294,7 +586,7 @@ ASP_COLD void SharedPtr<T>::destroyData() {
     std::atomic_thread_fence(std::memory_order::acquire);
 
     auto weak = WeakPtr<T>::adoptFromRaw(m_block);
-    m_block->dtor(m_block);
+    m_block->ops->destroy(m_block);
 
     // dtor of weak will handle the actual deallocation, if necessary
 }
@@ -312,7 +604,7 @@ template <typename T>
 ASP_COLD void WeakPtr<T>::destroyBlock() {
     std::atomic_thread_fence(std::memory_order::acquire);
 
-    ::operator delete(m_block);
+    m_block->ops->deallocate(m_block);
 }
 
 // Shared from this impl
@@ -0,0 +1,138 @@
+#pragma once
+#include "BoxedString.hpp"
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <string_view>
+
+namespace asp {
+
+namespace detail {
+
+struct SymbolEntry {
+    size_t hash;
+    std::atomic<size_t> refs;
+    BoxedString str;
+};
+
+}
+
+/// An interned string. Every distinct string has exactly one entry in a global, sharded intern table,
+/// so comparing two symbols is a single pointer comparison, and the hash is computed once, when the string is interned.
+///
+/// Interning takes a lock-free lookup in the common case that the string is already known, and locks one shard of the table otherwise.
+/// Entries are refcounted but never freed automatically: call `Symbol::collectUnused` to reclaim the ones no symbol refers to anymore.
+/// The empty symbol is represented without an entry, so default-constructed symbols cost nothing.
+class Symbol {
+public:
+    Symbol() noexcept = default;
+
+    /// Interns `str`, see `intern`.
+    explicit Symbol(std::string_view str);
+
+    /// Returns the symbol for `str`, adding it to the intern table if needed.
+    static Symbol intern(std::string_view str) {
+        return Symbol(str);
+    }
+
+    /// Returns the symbol for `str` if it is already interned, without adding it.
+    static std::optional<Symbol> find(std::string_view str);
+
+    /// Frees every interned string that is not referenced by any symbol, and returns how many were freed.
+    /// Symbols being interned concurrently are handled correctly, but the table is locked shard by shard while this runs.
+    static size_t collectUnused();
+
+    /// Returns the number of strings in the intern table, including unreferenced ones that were not collected yet.
+    static size_t internedCount();
+
+    Symbol(const Symbol& other) noexcept : m_entry(other.m_entry) {
+        this->retain();
+    }
+
+    Symbol& operator=(const Symbol& other) noexcept {
+        if (this != &other) {
+            this->release();
+            m_entry = other.m_entry;
+            this->retain();
+        }
+        return *this;
+    }
+
+    Symbol(Symbol&& other) noexcept : m_entry(std::exchange(other.m_entry, nullptr)) {}
+
+    Symbol& operator=(Symbol&& other) noexcept {
+        if (this != &other) {
+            this->release();
+            m_entry = std::exchange(other.m_entry, nullptr);
+        }
+        return *this;
+    }
+
+    ~Symbol() {
+        this->release();
+    }
+
+    std::string_view view() const noexcept {
+        return m_entry ? m_entry->str.view() : std::string_view{};
+    }
+
+    const char* c_str() const noexcept {
+        return m_entry ? m_entry->str.c_str() : "";
+    }
+
+    size_t size() const noexcept {
+        return this->view().size();
+    }
+
+    bool empty() const noexcept {
+        return m_entry == nullptr;
+    }
+
+    /// Returns the hash of the string, equal to `std::hash<std::string_view>` of `view()`.
+    size_t hash() const noexcept {
+        return m_entry ? m_entry->hash : std::hash<std::string_view>{}({});
+    }
+
+    /// Returns the interned string storage, without copying it.
+    BoxedString toBoxed() const {
+        return m_entry ? m_entry->str : BoxedString{};
+    }
+
+    operator std::string_view() const noexcept {
+        return this->view();
+    }
+
+    bool operator==(const Symbol& other) const noexcept {
+        return m_entry == other.m_entry;
+    }
+
+    bool operator==(std::string_view other) const noexcept {
+        return this->view() == other;
+    }
+
+private:
+    detail::SymbolEntry* m_entry = nullptr;
+
+    explicit Symbol(detail::SymbolEntry* entry) noexcept : m_entry(entry) {}
+
+    void retain() noexcept {
+        if (m_entry) m_entry->refs.fetch_add(1, std::memory_order::relaxed);
+    }
+
+    void release() noexcept {
+        if (m_entry) m_entry->refs.fetch_sub(1, std::memory_order::release);
+    }
+};
+
+inline auto format_as(const Symbol& s) -> std::string_view {
+    return s.view();
+}
+
+}
+
+template <>
+struct std::hash<asp::Symbol> {
+    size_t operator()(const asp::Symbol& s) const noexcept {
+        return s.hash();
+    }
+};
@@ -2,3 +2,4 @@
 
 #include "simd/base.hpp"
 #include "simd/CPUFeatures.hpp"
+#include "simd/Group.hpp"
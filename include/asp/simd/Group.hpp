@@ -0,0 +1,125 @@
+#pragma once
+#include "base.hpp"
+#include <asp/data/nums.hpp>
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define ASP_SIMD_GROUP_SSE2
+# include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+# define ASP_SIMD_GROUP_NEON
+# include <arm_neon.h>
+#endif
+
+namespace asp::simd {
+
+/// A set of byte positions within a `Group`, as returned by its `match` functions.
+/// `Shift` is log2 of the amount of bits used per byte.
+template <typename T, int Shift>
+class BitMask {
+public:
+    constexpr explicit BitMask(T bits) noexcept : m_bits(bits) {}
+
+    constexpr explicit operator bool() const noexcept {
+        return m_bits != 0;
+    }
+
+    /// Index of the first matching byte, the mask must not be empty.
+    constexpr size_t lowest() const noexcept {
+        return static_cast<size_t>(std::countr_zero(m_bits)) >> Shift;
+    }
+
+    constexpr void clearLowest() noexcept {
+        m_bits &= m_bits - 1;
+    }
+
+    /// Amount of non-matching bytes before the first match.
+    constexpr size_t trailingZeros() const noexcept {
+        return static_cast<size_t>(std::countr_zero(m_bits)) >> Shift;
+    }
+
+    /// Amount of non-matching bytes after the last match.
+    constexpr size_t leadingZeros() const noexcept {
+        return static_cast<size_t>(std::countl_zero(m_bits)) >> Shift;
+    }
+
+private:
+    T m_bits;
+};
+
+/// A group of bytes that can be compared all at once, using SSE2 (16 bytes) on x86, NEON (8 bytes) on ARM,
+/// and plain 64-bit arithmetic (8 bytes) elsewhere. Used to probe the control bytes of `asp::HashMap`.
+class Group {
+public:
+#if defined(ASP_SIMD_GROUP_SSE2)
+    static constexpr size_t WIDTH = 16;
+    using Mask = BitMask<u16, 0>;
+
+    explicit Group(const u8* bytes) noexcept : m_bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes))) {}
+
+    /// Returns the positions of all bytes equal to `byte`.
+    Mask match(u8 byte) const noexcept {
+        auto cmp = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)), m_bytes);
+        return Mask(static_cast<u16>(_mm_movemask_epi8(cmp)));
+    }
+
+    /// Returns the positions of all bytes with the highest bit set.
+    Mask matchHighBit() const noexcept {
+        return Mask(static_cast<u16>(_mm_movemask_epi8(m_bytes)));
+    }
+
+private:
+    __m128i m_bytes;
+
+#elif defined(ASP_SIMD_GROUP_NEON)
+    static constexpr size_t WIDTH = 8;
+    using Mask = BitMask<u64, 3>;
+
+    explicit Group(const u8* bytes) noexcept : m_bytes(vld1_u8(bytes)) {}
+
+    Mask match(u8 byte) const noexcept {
+        auto cmp = vceq_u8(vdup_n_u8(byte), m_bytes);
+        return Mask(vget_lane_u64(vreinterpret_u64_u8(cmp), 0) & MSBS);
+    }
+
+    Mask matchHighBit() const noexcept {
+        return Mask(vget_lane_u64(vreinterpret_u64_u8(m_bytes), 0) & MSBS);
+    }
+
+private:
+    static constexpr u64 MSBS = 0x8080808080808080ull;
+
+    uint8x8_t m_bytes;
+
+#else
+    static constexpr size_t WIDTH = 8;
+    using Mask = BitMask<u64, 3>;
+
+    explicit Group(const u8* bytes) noexcept {
+        std::memcpy(&m_bytes, bytes, sizeof(m_bytes));
+
+        if constexpr (std::endian::native == std::endian::big) {
+            m_bytes = std::byteswap(m_bytes);
+        }
+    }
+
+    Mask match(u8 byte) const noexcept {
+        // exact zero byte detection, without the false positives of the usual `(x - 0x01..) & ~x` trick
+        u64 x = m_bytes ^ (LSBS * byte);
+        return Mask(~(((x & ~MSBS) + ~MSBS) | x | ~MSBS));
+    }
+
+    Mask matchHighBit() const noexcept {
+        return Mask(m_bytes & MSBS);
+    }
+
+private:
+    static constexpr u64 LSBS = 0x0101010101010101ull;
+    static constexpr u64 MSBS = 0x8080808080808080ull;
+
+    u64 m_bytes;
+#endif
+};
+
+}
@@ -1,4 +1,21 @@
 #pragma once
 
+#include "sync/Barrier.hpp"
 #include "sync/Channel.hpp"
+#include "sync/ConcurrentHashMap.hpp"
+#include "sync/Condvar.hpp"
+#include "sync/Epoch.hpp"
+#include "sync/LockProfiler.hpp"
 #include "sync/Mutex.hpp"
+#include "sync/Notify.hpp"
+#include "sync/OnceCell.hpp"
+#include "sync/ParkingLot.hpp"
+#include "sync/PriorityChannel.hpp"
+#include "sync/RwLock.hpp"
+#include "sync/Semaphore.hpp"
+#include "sync/SeqLock.hpp"
+#include "sync/ShardedCounter.hpp"
+#include "sync/SpinLock.hpp"
+#include "sync/ThreadLocal.hpp"
+#include "sync/WaitGroup.hpp"
+#include "sync/WatchChannel.hpp"
@@ -0,0 +1,74 @@
+#pragma once
+#include "../detail/config.hpp"
+#include <asp/data/nums.hpp>
+#include <thread>
+
+#ifdef ASP_IS_X86
+# include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+# include <intrin.h>
+#endif
+
+namespace asp {
+
+/// Hints the CPU that the caller is in a spin-wait loop.
+void ASP_FORCE_INLINE inline cpuRelax() noexcept {
+#if defined(ASP_IS_X86)
+    _mm_pause();
+#elif defined(_MSC_VER)
+    __yield();
+#else
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/// Exponential backoff helper for spin loops.
+/// `spin()` is meant for retrying after a failed CAS, `snooze()` for waiting on another thread to make progress.
+class Backoff {
+public:
+    static constexpr u32 SPIN_LIMIT = 6;
+    static constexpr u32 YIELD_LIMIT = 10;
+
+    /// Backs off after a lost race on a shared variable. Never yields to the OS.
+    void spin() noexcept {
+        u32 count = 1u << (m_step < SPIN_LIMIT ? m_step : SPIN_LIMIT);
+        for (u32 i = 0; i < count; i++) {
+            cpuRelax();
+        }
+
+        if (m_step <= SPIN_LIMIT) {
+            m_step++;
+        }
+    }
+
+    /// Backs off while waiting for another thread. Starts by spinning, and eventually yields the time slice.
+    void snooze() noexcept {
+        if (m_step <= SPIN_LIMIT) {
+            for (u32 i = 0; i < (1u << m_step); i++) {
+                cpuRelax();
+            }
+        } else {
+            std::this_thread::yield();
+        }
+
+        if (m_step <= YIELD_LIMIT) {
+            m_step++;
+        }
+    }
+
+    /// Returns true once backing off has exceeded the spinning phase, and the caller should consider parking the thread.
+    bool isCompleted() const noexcept {
+        return m_step > YIELD_LIMIT;
+    }
+
+    void reset() noexcept {
+        m_step = 0;
+    }
+
+private:
+    u32 m_step = 0;
+};
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "../detail/config.hpp"
+#include <asp/detail/Function.hpp>
+#include <asp/data/nums.hpp>
+#include <asp/time/Duration.hpp>
+#include <asp/time/Instant.hpp>
+#include <atomic>
+
+namespace asp {
+
+/// A reusable barrier for a fixed amount of threads. Every phase completes once all threads have arrived,
+/// at which point the last arriving thread runs the completion function (if any) and releases everyone else.
+///
+/// Waiting threads spin briefly before parking, since in the common case of short phases the other threads arrive within microseconds.
+class Barrier {
+public:
+    /// Identifies the phase a thread arrived at, to be passed to `wait`.
+    struct ArrivalToken {
+        u32 phase;
+    };
+
+    Barrier(u32 count, asp::MoveOnlyFunction<void()> completion = {})
+        : m_count(count), m_completion(std::move(completion)) {}
+
+    Barrier(const Barrier&) = delete;
+    Barrier& operator=(const Barrier&) = delete;
+    Barrier(Barrier&&) = delete;
+    Barrier& operator=(Barrier&&) = delete;
+
+    /// Arrives at the barrier and waits for the current phase to complete.
+    /// Returns true for exactly one thread per phase, the one that ran the completion function.
+    bool arriveAndWait() noexcept;
+
+    /// Arrives at the barrier without waiting. If this was the last thread to arrive, completes the phase.
+    ArrivalToken arrive() noexcept;
+
+    /// Waits for the phase identified by `token` to complete.
+    void wait(ArrivalToken token) const noexcept {
+        this->waitUntil(token, Instant::farFuture());
+    }
+
+    /// Waits for the phase identified by `token` to complete, or until the timeout expires.
+    /// Returns false if the timeout expired, the thread still counts as arrived and can wait again with the same token.
+    bool wait(ArrivalToken token, const time::Duration& timeout) const noexcept {
+        return this->waitUntil(token, Instant::now() + timeout);
+    }
+
+    /// Like `wait` with a timeout, but with an absolute deadline.
+    bool waitUntil(ArrivalToken token, const time::Instant& deadline) const noexcept;
+
+    /// Returns the amount of threads that participate in every phase.
+    u32 count() const noexcept {
+        return m_count;
+    }
+
+private:
+    u32 m_count;
+    std::atomic<u32> m_arrived{0};
+    // incremented every time a phase completes, waiters park on this
+    mutable std::atomic<u32> m_phase{0};
+    mutable std::atomic<u32> m_sleepers{0};
+    asp::MoveOnlyFunction<void()> m_completion;
+
+    bool arriveImpl(u32& phase) noexcept;
+};
+
+}
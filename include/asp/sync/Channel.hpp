@@ -1,5 +1,6 @@
 #pragma once
 #include "Mutex.hpp"
+#include "SegQueue.hpp"
 
 #include <condition_variable>
 #include <queue>
@@ -10,9 +11,18 @@
 
 namespace asp {
 
+namespace channel {
+    /// Default channel backend, a `std::queue` guarded by a mutex.
+    struct Locked {};
+
+    /// Lock-free channel backend built on `SegQueue`. Senders and receivers never serialize on a lock,
+    /// a mutex is only taken to put receivers to sleep when the channel is empty.
+    struct LockFree {};
+}
+
 /// Thread-safe message queue for exchanging data between multiple threads.
 /// Can have multiple senders and receivers.
-template <typename T>
+template <typename T, typename Policy = channel::Locked>
 class Channel {
 public:
     Channel() {}
@@ -36,7 +46,7 @@ public:
 
         cvar.wait(lock, [this] { return !queue.empty(); });
 
-        return doPop(queue.data);
+        return doPop(queue);
     }
 
     // Like `pop`, but will return `std::nullopt` if the given timeout expires before there's available data.
@@ -122,4 +132,128 @@ private:
     }
 };
 
-}
\ No newline at end of file
+/// Lock-free specialization, see `channel::LockFree`.
+template <typename T>
+class Channel<T, channel::LockFree> {
+public:
+    Channel() {}
+
+    bool empty() const {
+        return queue.empty();
+    }
+
+    size_t size() const {
+        return queue.size();
+    }
+
+    // Obtains the element at the front of the queue, if the channel is empty, blocks until there's data.
+    T pop() {
+        while (true) {
+            if (auto val = this->tryPop()) {
+                return std::move(*val);
+            }
+
+            this->sleepUntilNotEmpty(std::nullopt);
+        }
+    }
+
+    // Like `pop`, but will return `std::nullopt` if the given timeout expires before there's available data.
+    std::optional<T> popTimeout(const time::Duration& timeout) {
+        return popTimeout(time::toChrono<std::chrono::microseconds>(timeout));
+    }
+
+    // Like `pop`, but will return `std::nullopt` if the given timeout expires before there's available data.
+    template <typename Rep, typename Period>
+    std::optional<T> popTimeout(std::chrono::duration<Rep, Period> timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        while (true) {
+            if (auto val = this->tryPop()) {
+                return val;
+            }
+
+            if (!this->sleepUntilNotEmpty(deadline)) {
+                // one last attempt, in case a message arrived right at the deadline
+                return this->tryPop();
+            }
+        }
+    }
+
+    // Blocks until messages are available, does not actually pop any messages from the channel.
+    void waitForMessages(const time::Duration& timeout) {
+        waitForMessages(time::toChrono<std::chrono::microseconds>(timeout));
+    }
+
+    // Blocks until messages are available, does not actually pop any messages from the channel.
+    template <typename Rep, typename Period>
+    void waitForMessages(std::chrono::duration<Rep, Period> timeout) {
+        if (!queue.empty()) {
+            return;
+        }
+
+        this->sleepUntilNotEmpty(std::chrono::steady_clock::now() + timeout);
+    }
+
+    // Obtains the element at the front of the queue, throws if the channel is empty.
+    T popNow() {
+        auto val = queue.pop();
+        if (!val) {
+            throw std::runtime_error("attempting to pop a message from an empty channel");
+        }
+
+        return std::move(*val);
+    }
+
+    // Returns the element at the front of the queue if present, otherwise returns `std::nullopt`.
+    std::optional<T> tryPop() {
+        return queue.pop();
+    }
+
+    // Pushes a new message to the queue.
+    void push(const T& msg) {
+        queue.push(msg);
+        this->wakeOne();
+    }
+
+    // Pushes a new message to the queue.
+    void push(T&& msg) {
+        queue.push(std::move(msg));
+        this->wakeOne();
+    }
+
+private:
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    SegQueue<T> queue;
+    std::atomic<size_t> sleepers{0};
+    std::mutex mtx;
+    std::condition_variable cvar;
+
+    void wakeOne() {
+        // the push and this load are both seq_cst, so either we see the sleeper, or the sleeper sees the message
+        if (sleepers.load(std::memory_order::seq_cst) != 0) {
+            std::unique_lock lock(mtx);
+            cvar.notify_one();
+        }
+    }
+
+    // Returns false if the deadline expired while the queue was still empty.
+    bool sleepUntilNotEmpty(std::optional<Deadline> deadline) {
+        sleepers.fetch_add(1, std::memory_order::seq_cst);
+
+        std::unique_lock lock(mtx);
+        auto pred = [this] { return !queue.empty(); };
+
+        bool result = true;
+        if (deadline) {
+            result = cvar.wait_until(lock, *deadline, pred);
+        } else {
+            cvar.wait(lock, pred);
+        }
+
+        sleepers.fetch_sub(1, std::memory_order::relaxed);
+        return result;
+    }
+};
+
+}
@@ -0,0 +1,223 @@
+#pragma once
+#include "../detail/config.hpp"
+#include "RwLock.hpp"
+#include <asp/collections/HashMap.hpp>
+#include <asp/thread/Thread.hpp>
+#include <bit>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace asp {
+
+/// A hash map that can be used from many threads at once. The map is split into shards by the hash of the key,
+/// each shard being a `HashMap` behind its own `RawRwLock`, so threads only contend when they hit the same shard,
+/// and readers of a shard don't block each other.
+///
+/// Elements are never handed out by reference, as they could be moved or destroyed as soon as the shard is unlocked.
+/// Lookups return copies, and everything else is done through callbacks that run while the shard is locked.
+/// Callbacks must not access the map themselves, that would deadlock if they hit the same shard.
+template <typename K, typename V, typename Hash = DefaultHash<K>, typename Eq = std::equal_to<>>
+class ConcurrentHashMap {
+public:
+    using Map = HashMap<K, V, Hash, Eq>;
+
+    template <typename Q>
+    static constexpr bool IS_KEY = Map::template IS_KEY<Q>;
+
+    /// Creates a map with `shards` shards, rounded up to a power of two. By default, uses 4 shards per CPU.
+    explicit ConcurrentHashMap(size_t shards = 0) {
+        if (shards == 0) {
+            shards = static_cast<size_t>(cpuShardCount()) * 4;
+        }
+
+        shards = std::bit_ceil(shards);
+        m_shards = std::make_unique<Shard[]>(shards);
+        m_shardShift = sizeof(size_t) * 8 - std::countr_zero(shards);
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap(ConcurrentHashMap&&) = delete;
+    ConcurrentHashMap& operator=(ConcurrentHashMap&&) = delete;
+
+    /// Returns a copy of the value at the given key, or nothing if not present.
+    template <typename Q> requires IS_KEY<Q>
+    std::optional<V> get(const Q& key) const {
+        auto map = this->shardFor(key).read();
+
+        if (auto value = map->get(key)) {
+            return *value;
+        }
+
+        return std::nullopt;
+    }
+
+    template <typename Q> requires IS_KEY<Q>
+    bool contains(const Q& key) const {
+        return this->shardFor(key).read()->contains(key);
+    }
+
+    /// Calls `f(const V&)` with the value at the given key while its shard is read locked. Returns whether the key was present.
+    template <typename Q, typename F> requires IS_KEY<Q>
+    bool visit(const Q& key, F&& f) const {
+        auto map = this->shardFor(key).read();
+
+        if (auto value = map->get(key)) {
+            std::forward<F>(f)(*value);
+            return true;
+        }
+
+        return false;
+    }
+
+    /// Inserts the value if the key is not present. Returns whether it was inserted.
+    template <typename KArg, typename... Args>
+    bool insert(KArg&& key, Args&&... args) {
+        auto map = this->shardFor(key).write();
+        return map->try_emplace(std::forward<KArg>(key), std::forward<Args>(args)...).second;
+    }
+
+    /// Inserts the value, or replaces the existing one. Returns whether it was inserted.
+    template <typename KArg, typename M>
+    bool insertOrAssign(KArg&& key, M&& value) {
+        auto map = this->shardFor(key).write();
+        return map->insert_or_assign(std::forward<KArg>(key), std::forward<M>(value)).second;
+    }
+
+    /// Atomically inserts `value` if the key is not present, or calls `update(V&)` on the existing value otherwise.
+    /// Returns whether the value was inserted.
+    template <typename KArg, typename M, typename F>
+    bool upsert(KArg&& key, M&& value, F&& update) {
+        auto map = this->shardFor(key).write();
+        auto [it, inserted] = map->try_emplace(std::forward<KArg>(key), std::forward<M>(value));
+
+        if (!inserted) {
+            std::forward<F>(update)(it->second);
+        }
+
+        return inserted;
+    }
+
+    /// Returns a copy of the value at the given key, inserting the result of `make()` first if it's not present.
+    /// `make` is called at most once, and only if no other thread inserted the key in the meantime.
+    template <typename KArg, typename F>
+    V computeIfAbsent(KArg&& key, F&& make) {
+        auto& shard = this->shardFor(key);
+
+        // most calls find the value, try that without excluding other readers first
+        {
+            auto map = shard.read();
+            if (auto value = map->get(key)) {
+                return *value;
+            }
+        }
+
+        auto map = shard.write();
+        if (auto value = map->get(key)) {
+            return *value;
+        }
+
+        return map->try_emplace(std::forward<KArg>(key), std::forward<F>(make)()).first->second;
+    }
+
+    /// Calls `f(V&)` on the value at the given key while its shard is write locked. Returns whether the key was present.
+    template <typename Q, typename F> requires IS_KEY<Q>
+    bool update(const Q& key, F&& f) {
+        auto map = this->shardFor(key).write();
+
+        if (auto value = map->get(key)) {
+            std::forward<F>(f)(*value);
+            return true;
+        }
+
+        return false;
+    }
+
+    /// Removes the value at the given key and returns it, or nothing if not present.
+    template <typename Q> requires IS_KEY<Q>
+    std::optional<V> take(const Q& key) {
+        auto map = this->shardFor(key).write();
+
+        auto it = map->find(key);
+        if (it == map->end()) return std::nullopt;
+
+        std::optional<V> value{std::move(it->second)};
+        map->erase(it);
+        return value;
+    }
+
+    template <typename Q> requires IS_KEY<Q>
+    bool erase(const Q& key) {
+        return this->shardFor(key).write()->erase(key);
+    }
+
+    /// Calls `f(const K&, const V&)` for every element. Each shard is read locked while it is being visited, so every shard is seen in a consistent state,
+    /// but elements inserted or removed concurrently in other shards may or may not be visited.
+    template <typename F>
+    void forEach(F&& f) const {
+        for (size_t i = 0; i < this->shardCount(); i++) {
+            auto map = m_shards[i].map.read();
+
+            for (auto& [key, value] : *map) {
+                f(key, value);
+            }
+        }
+    }
+
+    /// Calls `f(const K&, V&)` for every element, removing the ones for which it returns false. Shards are write locked one at a time, see `forEach`.
+    template <typename F>
+    void retain(F&& f) {
+        for (size_t i = 0; i < this->shardCount(); i++) {
+            auto map = m_shards[i].map.write();
+
+            for (auto it = map->begin(); it != map->end();) {
+                it = f(it->first, it->second) ? std::next(it) : map->erase(it);
+            }
+        }
+    }
+
+    /// Returns the amount of elements. Not a snapshot, concurrent changes to other shards may or may not be counted.
+    size_t size() const {
+        size_t size = 0;
+
+        for (size_t i = 0; i < this->shardCount(); i++) {
+            size += m_shards[i].map.read()->size();
+        }
+
+        return size;
+    }
+
+    bool empty() const {
+        return this->size() == 0;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < this->shardCount(); i++) {
+            m_shards[i].map.write()->clear();
+        }
+    }
+
+    size_t shardCount() const noexcept {
+        return static_cast<size_t>(1) << (sizeof(size_t) * 8 - m_shardShift);
+    }
+
+private:
+    struct alignas(ASP_CACHE_LINE_SIZE) Shard {
+        RwLock<Map> map;
+    };
+
+    std::unique_ptr<Shard[]> m_shards;
+    size_t m_shardShift;
+    [[no_unique_address]] Hash m_hash{};
+
+    template <typename Q>
+    const RwLock<Map>& shardFor(const Q& key) const {
+        // the top bits pick the shard, the map inside uses the low ones
+        size_t hash = detail::mixHash(m_hash(key));
+        size_t index = m_shardShift == sizeof(size_t) * 8 ? 0 : hash >> m_shardShift;
+        return m_shards[index].map;
+    }
+};
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "../detail/config.hpp"
+#include "RawMutex.hpp"
+#include <asp/time/Instant.hpp>
+#include <atomic>
+
+namespace asp {
+
+/// A condition variable for `asp::Mutex`, waited on through `MutexGuard::wait`, which releases the mutex and re-acquires it after waking up.
+/// A `Condvar` can only be used with one mutex at a time.
+///
+/// Waiters are parked in the global parking lot. When `notifyAll` (or `notifyOne` while the mutex is held) is called, the waiters
+/// are moved straight to the mutex's queue instead of being woken up, so they don't all stampede the mutex only to go back to sleep on it.
+/// Waits can wake up spuriously, so the waited-for state should always be rechecked, the predicate overloads of `MutexGuard::wait` do that.
+class Condvar {
+public:
+    Condvar() = default;
+
+    Condvar(const Condvar&) = delete;
+    Condvar& operator=(const Condvar&) = delete;
+    Condvar(Condvar&&) = delete;
+    Condvar& operator=(Condvar&&) = delete;
+
+    /// Wakes up one waiting thread, or hands it to the mutex if it is currently locked.
+    void notifyOne() noexcept {
+        if (m_mutex.load(std::memory_order::relaxed)) {
+            this->notifyOneSlow();
+        }
+    }
+
+    /// Wakes up all waiting threads. If the mutex is unlocked, one of them is woken up and the rest are handed to the mutex,
+    /// otherwise they are all handed to the mutex.
+    void notifyAll() noexcept {
+        if (m_mutex.load(std::memory_order::relaxed)) {
+            this->notifyAllSlow();
+        }
+    }
+
+    /// Atomically unlocks `mutex` (which must be locked by the calling thread) and waits for a notification,
+    /// then locks `mutex` again. Returns false if the deadline was reached first.
+    /// Prefer `MutexGuard::wait`, which calls this.
+    bool waitUntil(RawMutex& mutex, const time::Instant& deadline) noexcept;
+
+private:
+    // the mutex the waiters are using, null if there are none
+    std::atomic<RawMutex*> m_mutex{nullptr};
+
+    ASP_COLD void notifyOneSlow() noexcept;
+    ASP_COLD void notifyAllSlow() noexcept;
+};
+
+}
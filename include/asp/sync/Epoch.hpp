@@ -0,0 +1,97 @@
+#pragma once
+#include "../detail/config.hpp"
+#include <asp/data/nums.hpp>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/// Epoch-based memory reclamation, for lock-free data structures whose nodes may still be read by other threads after being unlinked.
+///
+/// Readers `pin()` the current thread for as long as they hold pointers into the structure. Writers that unlink a node
+/// pass it to `defer` instead of freeing it, and it is only destroyed once every thread that was pinned at that moment has unpinned.
+///
+/// Deferred objects are collected in a per-thread bag, which is handed off to a global queue once it fills up.
+/// The global epoch is advanced and expired bags are freed in batches, every so often while pinning.
+/// Threads are registered on their first `pin()` (or when an `asp::Thread` starts), and unregistered when they exit.
+namespace asp::epoch {
+
+/// Keeps the current thread pinned while alive. Pinning is reentrant, only the outermost guard actually unpins.
+class [[nodiscard("An epoch guard must be stored in a variable to be effective")]] Guard {
+public:
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+    Guard(Guard&& other) noexcept : m_pinned(std::exchange(other.m_pinned, false)) {}
+
+    Guard& operator=(Guard&& other) noexcept {
+        if (this != &other) {
+            this->unpin();
+            m_pinned = std::exchange(other.m_pinned, false);
+        }
+        return *this;
+    }
+
+    ~Guard() {
+        this->unpin();
+    }
+
+    /// Schedules `ptr` to be destroyed with `deleter` once no thread can be reading it anymore.
+    template <typename T, typename Deleter = std::default_delete<T>>
+    void defer(T* ptr, Deleter deleter = {}) const {
+        if constexpr (std::is_empty_v<Deleter> && std::is_default_constructible_v<Deleter>) {
+            deferRaw(ptr, [](void* p) {
+                Deleter{}(static_cast<T*>(p));
+            });
+        } else {
+            // stateful deleters are boxed together with the pointer
+            using Boxed = std::pair<T*, Deleter>;
+            deferRaw(new Boxed(ptr, std::move(deleter)), [](void* p) {
+                auto boxed = static_cast<Boxed*>(p);
+                boxed->second(boxed->first);
+                delete boxed;
+            });
+        }
+    }
+
+    /// Schedules an arbitrary function to be called with `ptr` once no thread can be reading it anymore.
+    void deferRaw(void* ptr, void (*fn)(void*)) const;
+
+    /// Hands the current thread's bag of deferred objects off for collection, and tries to free expired ones.
+    /// Useful before a thread goes idle for a long time.
+    void flush() const;
+
+    /// Unpins early. The guard must not be used afterwards.
+    void unpin() noexcept;
+
+private:
+    friend Guard pin();
+
+    bool m_pinned;
+
+    explicit Guard(bool pinned) noexcept : m_pinned(pinned) {}
+};
+
+/// Pins the current thread, registering it if it's the first time.
+/// While the returned guard is alive, objects deferred by any thread are not destroyed.
+Guard pin();
+
+/// Returns whether the current thread is pinned.
+bool isPinned() noexcept;
+
+/// Pins the current thread just to defer `ptr`, see `Guard::defer`.
+template <typename T, typename Deleter = std::default_delete<T>>
+void defer(T* ptr, Deleter deleter = {}) {
+    pin().defer(ptr, std::move(deleter));
+}
+
+/// Registers the current thread. Done automatically on the first `pin()` and when an `asp::Thread` starts.
+void registerThread();
+
+/// Hands off the current thread's deferred objects and unregisters it. Done automatically when the thread exits,
+/// `asp::Thread` calls this after running its termination hook. Must not be called while pinned.
+void unregisterThread();
+
+/// Returns the current global epoch, mostly useful for tests and diagnostics.
+u64 currentEpoch() noexcept;
+
+}
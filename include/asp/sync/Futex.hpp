@@ -0,0 +1,39 @@
+#pragma once
+#include <asp/detail/config.hpp>
+#include <asp/data/nums.hpp>
+#include <asp/time/Duration.hpp>
+#include <asp/time/Instant.hpp>
+#include <atomic>
+
+namespace asp::futex {
+
+static_assert(sizeof(std::atomic<u32>) == sizeof(u32), "futex words must be plain 32-bit integers");
+
+/// Blocks the calling thread as long as `word` holds `expected`, until woken by `wakeOne`/`wakeAll` or until the timeout expires.
+/// The timeout is measured against a monotonic clock. May return spuriously, callers must recheck their condition.
+/// Returns false only if the timeout expired.
+bool wait(const std::atomic<u32>& word, u32 expected, const time::Duration& timeout = time::Duration::infinite());
+
+/// Like `wait`, but with an absolute deadline, `Instant::farFuture()` waits without a timeout.
+/// This is what the blocking primitives in `asp::sync` park on. Returns false only if the deadline was reached.
+inline bool waitUntil(const std::atomic<u32>& word, u32 expected, const time::Instant& deadline) {
+    if (deadline == time::Instant::farFuture()) {
+        return wait(word, expected);
+    }
+
+    auto now = time::Instant::now();
+    if (now >= deadline) {
+        return false;
+    }
+
+    return wait(word, expected, deadline.durationSince(now));
+}
+
+/// Wakes up at most one thread blocked in `wait` on this word.
+/// Returns true if a thread was woken up. On platforms that can't tell (Windows), always returns false.
+bool wakeOne(const std::atomic<u32>& word);
+
+/// Wakes up all threads blocked in `wait` on this word.
+void wakeAll(const std::atomic<u32>& word);
+
+}
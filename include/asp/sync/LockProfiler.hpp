@@ -0,0 +1,117 @@
+#pragma once
+#include "../detail/config.hpp"
+#include <asp/data/nums.hpp>
+#include <asp/time/Duration.hpp>
+#include <asp/time/Instant.hpp>
+#include <atomic>
+#include <source_location>
+#include <string>
+#include <vector>
+
+/// Lock contention profiling. When the library is built with `ASP_LOCK_PROFILING` (the CMake option of the same name),
+/// every `asp::Mutex` and `asp::SpinLock` acquisition is recorded against the source location that called `lock()`.
+/// When the flag is off, the locks contain no profiling code at all, and `snapshot()` returns nothing.
+namespace asp::lockprof {
+
+/// Statistics about all acquisitions of locks from a single call site.
+struct SiteStats {
+    std::source_location location;
+    u64 acquisitions;
+    // acquisitions where the lock was already held and the thread had to wait
+    u64 contended;
+    time::Duration totalWait;
+    time::Duration maxWait;
+    time::Duration totalHold;
+    time::Duration maxHold;
+};
+
+/// Returns the statistics of every call site that acquired a lock so far, sorted by total wait time, highest first.
+std::vector<SiteStats> snapshot();
+
+/// Formats the output of `snapshot()` as a human readable table, one call site per line.
+std::string dump(size_t maxSites = 32);
+
+/// Zeroes the statistics of all call sites.
+void reset();
+
+/// Returns whether the library was built with lock profiling enabled.
+constexpr bool enabled() noexcept {
+#ifdef ASP_LOCK_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+class Site;
+
+/// Returns the statistics slot of the given call site, registering it on first use. Never fails,
+/// once the fixed size registry is full, all new call sites share a single overflow slot.
+Site& site(const std::source_location& location) noexcept;
+
+class Site {
+public:
+    void recordAcquire(bool contended, const time::Duration& wait) noexcept;
+    void recordHold(const time::Duration& hold) noexcept;
+
+private:
+    friend Site& site(const std::source_location&) noexcept;
+    friend std::vector<SiteStats> snapshot();
+    friend void reset();
+
+    // 0 - empty, 1 - being registered, 2 - ready
+    std::atomic<u32> m_state{0};
+    std::source_location m_location;
+    std::atomic<u64> m_acquisitions{0};
+    std::atomic<u64> m_contended{0};
+    std::atomic<u64> m_waitNanos{0};
+    std::atomic<u64> m_maxWaitNanos{0};
+    std::atomic<u64> m_holdNanos{0};
+    std::atomic<u64> m_maxHoldNanos{0};
+};
+
+/// Embedded into lock guards when profiling is enabled, measures a single acquisition and how long the lock was held.
+class Probe {
+public:
+    /// Acquires the lock through `tryLock` and `lock`, recording whether the fast path succeeded and how long it took otherwise.
+    template <typename TryLock, typename Lock>
+    void acquire(const std::source_location& location, TryLock&& tryLock, Lock&& lock) {
+        m_site = &site(location);
+
+        if (tryLock()) {
+            m_acquiredAt = Instant::now();
+            m_site->recordAcquire(false, time::Duration{});
+        } else {
+            auto start = Instant::now();
+            lock();
+            m_acquiredAt = Instant::now();
+            m_site->recordAcquire(true, m_acquiredAt.durationSince(start));
+        }
+    }
+
+    /// Must be called right before the lock is released.
+    void release() noexcept {
+        if (m_site) {
+            m_site->recordHold(m_acquiredAt.elapsed());
+            m_site = nullptr;
+        }
+    }
+
+    /// Splits the hold time around a condition wait, which releases and re-acquires the lock internally.
+    /// `suspend` must be called right before the wait, `resume` right after it.
+    void suspend() noexcept {
+        if (m_site) {
+            m_site->recordHold(m_acquiredAt.elapsed());
+        }
+    }
+
+    void resume() noexcept {
+        m_acquiredAt = Instant::now();
+    }
+
+private:
+    Site* m_site = nullptr;
+    Instant m_acquiredAt;
+};
+
+}
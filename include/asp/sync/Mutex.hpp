@@ -1,13 +1,19 @@
 #pragma once
 #include "../detail/config.hpp"
+#include "RawMutex.hpp"
+#include "Condvar.hpp"
+#include "LockProfiler.hpp"
 #include <asp/Log.hpp>
+#include <asp/time/Duration.hpp>
+#include <asp/time/Instant.hpp>
+#include <concepts>
 #include <utility>
 #include <mutex>
 #include <fmt/format.h>
 
 namespace asp {
 
-template <typename T>
+template <typename T, typename Policy>
 class Channel;
 
 template <typename T, bool Recursive>
@@ -19,9 +25,15 @@ public:
     MutexGuardBase(const MutexGuardBase&) = delete;
     MutexGuardBase& operator=(const MutexGuardBase&) = delete;
 
+#ifdef ASP_LOCK_PROFILING
+    MutexGuardBase(Mutex<T, Recursive>& mutex, std::source_location loc = std::source_location::current()) : mtx(&mutex) {
+        this->relock(loc);
+    }
+#else
     MutexGuardBase(Mutex<T, Recursive>& mutex) : mtx(&mutex) {
         this->relock();
     }
+#endif
 
     MutexGuardBase(MutexGuardBase&& other) noexcept {
         *this = std::move(other);
@@ -31,6 +43,9 @@ public:
         if (this != &other) {
             this->mtx = other.mtx;
             this->locked = other.locked;
+#ifdef ASP_LOCK_PROFILING
+            this->probe = std::exchange(other.probe, {});
+#endif
 
             other.mtx = nullptr;
             other.locked = false;
@@ -47,10 +62,21 @@ public:
     void unlock() {
         if (!locked) return;
 
+#ifdef ASP_LOCK_PROFILING
+        probe.release();
+#endif
         mtx->m_mtx.unlock();
         locked = false;
     }
 
+#ifdef ASP_LOCK_PROFILING
+    void relock(std::source_location loc = std::source_location::current()) {
+        if (locked) return;
+
+        probe.acquire(loc, [this] { return mtx->m_mtx.try_lock(); }, [this] { mtx->m_mtx.lock(); });
+        locked = true;
+    }
+#else
     void relock() {
         if (locked) return;
 
@@ -67,14 +93,62 @@ public:
 #endif
         locked = true;
     }
+#endif
+
+    /// Atomically unlocks the mutex and waits for `cond` to be notified, then locks the mutex again.
+    /// This can wake up spuriously, prefer the overloads that take a predicate.
+    void wait(Condvar& cond) requires (!Recursive) {
+        this->waitUntil(cond, Instant::farFuture());
+    }
+
+    /// Like `wait(cond)`, but gives up after the timeout. Returns false if the timeout expired.
+    bool wait(Condvar& cond, const time::Duration& timeout) requires (!Recursive) {
+        return this->waitUntil(cond, Instant::now() + timeout);
+    }
+
+    /// Waits on `cond` until `pred` returns true. The predicate is always called with the mutex locked.
+    /// Returns the last result of `pred`, which is false only if the timeout expired.
+    template <std::predicate F>
+    bool wait(Condvar& cond, F&& pred, const time::Duration& timeout = time::Duration::infinite()) requires (!Recursive) {
+        return this->waitUntil(cond, std::forward<F>(pred), Instant::now() + timeout);
+    }
+
+    /// Like `wait(cond)`, but gives up once the deadline is reached. Returns false if it was reached.
+    bool waitUntil(Condvar& cond, const time::Instant& deadline) requires (!Recursive) {
+#ifdef ASP_LOCK_PROFILING
+        probe.suspend();
+        bool notified = cond.waitUntil(mtx->m_mtx, deadline);
+        probe.resume();
+        return notified;
+#else
+        return cond.waitUntil(mtx->m_mtx, deadline);
+#endif
+    }
+
+    /// Waits on `cond` until `pred` returns true or the deadline is reached. Returns the last result of `pred`.
+    template <std::predicate F>
+    bool waitUntil(Condvar& cond, F&& pred, const time::Instant& deadline) requires (!Recursive) {
+        while (!pred()) {
+            if (!this->waitUntil(cond, deadline)) {
+                return pred();
+            }
+        }
+
+        return true;
+    }
 
 protected:
     Mutex<T, Recursive>* mtx;
     bool locked = false;
+#ifdef ASP_LOCK_PROFILING
+    lockprof::Probe probe;
+#endif
 };
 
 template <typename T = void, bool Recursive = false>
 struct MutexGuard : public MutexGuardBase<T, Recursive> {
+    using MutexGuardBase<T, Recursive>::MutexGuardBase;
+
     T& operator*() {
         return this->mtx->m_data;
     }
@@ -105,7 +179,8 @@ struct MutexGuard : public MutexGuardBase<T, Recursive> {
 // Specializations for void and non void
 template <bool Recursive>
 class MutexGuard<void, Recursive> : public MutexGuardBase<void, Recursive> {
-    // nothing!
+public:
+    using MutexGuardBase<void, Recursive>::MutexGuardBase;
 };
 
 template <typename T = void, bool Recursive = false>
@@ -114,7 +189,7 @@ public:
     using MutexType = std::conditional_t<
         Recursive,
         std::recursive_mutex,
-        std::mutex>;
+        RawMutex>;
 
     MutexBase() = default;
 
@@ -124,7 +199,7 @@ public:
     MutexBase& operator=(MutexBase&&) = delete;
 
 protected:
-    template <typename U>
+    template <typename U, typename P>
     friend class Channel;
     template <typename U, bool R>
     friend class MutexGuardBase;
@@ -140,9 +215,15 @@ public:
     template <typename... Args>
     Mutex(Args&&... args) : m_data(std::forward<Args>(args)...) {}
 
+#ifdef ASP_LOCK_PROFILING
+    Guard lock(std::source_location loc = std::source_location::current()) const {
+        return Guard(const_cast<Mutex<T, Recursive>&>(*this), loc);
+    }
+#else
     Guard lock() const {
         return Guard(const_cast<Mutex<T, Recursive>&>(*this));
     }
+#endif
 
 private:
     friend class MutexGuard<T, Recursive>;
@@ -157,9 +238,15 @@ public:
 
     Mutex() = default;
 
+#ifdef ASP_LOCK_PROFILING
+    Guard lock(std::source_location loc = std::source_location::current()) const {
+        return Guard(const_cast<Mutex<void, Recursive>&>(*this), loc);
+    }
+#else
     Guard lock() const {
         return Guard(const_cast<Mutex<void, Recursive>&>(*this));
     }
+#endif
 
 private:
     friend class MutexGuard<void, Recursive>;
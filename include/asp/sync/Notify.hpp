@@ -2,33 +2,29 @@
 
 #include <asp/detail/config.hpp>
 #include <asp/detail/Function.hpp>
+#include <asp/data/nums.hpp>
 #include <asp/time/Duration.hpp>
-
-#ifndef ASP_IS_WIN
-# include <pthread.h>
-#else
-
-struct _RTL_CRITICAL_SECTION;
-typedef struct _RTL_CRITICAL_SECTION CRITICAL_SECTION;
-struct _RTL_CONDITION_VARIABLE;
-typedef struct _RTL_CONDITION_VARIABLE CONDITION_VARIABLE;
-
-#endif
+#include <asp/time/Instant.hpp>
+#include <atomic>
 
 namespace asp {
 
 /// Thread-safe notification mechanism for signaling between threads.
+/// Occupies a single byte and parks waiters in the global parking lot, timeouts are measured against the monotonic clock.
+///
+/// `notifyOne()` stores a permit if nobody is waiting, which is then consumed by the next call to `wait()`,
+/// so a notification sent right before the other thread starts waiting is not lost.
+/// At most one permit is stored this way, notifying multiple times with no waiters is the same as notifying once.
 class Notify {
 public:
-    Notify();
-    ~Notify();
+    Notify() = default;
 
     Notify(const Notify&) = delete;
     Notify& operator=(const Notify&) = delete;
     Notify(Notify&&) = delete;
     Notify& operator=(Notify&&) = delete;
 
-    /// Waits for a notification
+    /// Waits for a notification, or consumes a stored permit.
     void wait();
 
     /// Waits for a notification with a timeout.
@@ -40,27 +36,68 @@ public:
     /// Specify the timeout as 0 to wait indefinitely.
     bool wait(const time::Duration& timeout, asp::FunctionRef<bool()> predicate);
 
-    /// Notifies one waiting thread
+    /// Waits for a notification until the given deadline.
+    /// Returns true if notified, false if the deadline was reached.
+    bool waitUntil(const time::Instant& deadline);
+
+    /// Notifies one waiting thread. If there are no waiting threads, stores a permit for the next one.
     void notifyOne();
 
-    /// Notifies all waiting threads
+    /// Notifies all waiting threads. Does not store a permit.
     void notifyAll();
 
 private:
-#ifdef ASP_IS_WIN
-    alignas(8) char _critStorage[40];
-    alignas(8) char _condStorage[8];
+    // a stored permit in bit 0, "threads may be parked" in bit 1, and a notifyAll epoch in the top 6 bits
+    std::atomic<u8> m_state{0};
 
-    CRITICAL_SECTION* _crit();
-    CONDITION_VARIABLE* _cond();
-#else
-    pthread_mutex_t _mutexStorage;
-    pthread_cond_t _condStorage;
+    bool waitImpl(const time::Instant& deadline, int epoch);
+};
+
+static_assert(sizeof(Notify) == 1);
 
-    pthread_mutex_t* _mutex();
-    pthread_cond_t* _cond();
+/// A notification primitive backed by an OS handle (eventfd on Linux, a pipe on other unix systems, an event on Windows),
+/// so that it can be waited on together with sockets and other file descriptors using `poll`/`epoll`/`WaitForMultipleObjects`.
+/// Notifications are coalesced into a single permit, which is consumed by `wait` or `consume`.
+/// This is heavier than `Notify`, only use it when the handle is needed.
+class PollableNotify {
+public:
+#ifdef ASP_IS_WIN
+    using NativeHandle = void*;
+#else
+    using NativeHandle = int;
 #endif
 
+    PollableNotify();
+    ~PollableNotify();
+
+    PollableNotify(const PollableNotify&) = delete;
+    PollableNotify& operator=(const PollableNotify&) = delete;
+    PollableNotify(PollableNotify&&) = delete;
+    PollableNotify& operator=(PollableNotify&&) = delete;
+
+    /// Stores a permit and wakes up a waiter, or makes the handle readable (signaled) if it is being polled.
+    void notify();
+
+    /// Waits for a permit and consumes it.
+    void wait();
+
+    /// Waits for a permit and consumes it. Returns false if the timeout expired first.
+    bool wait(const time::Duration& timeout);
+
+    /// Consumes the permit without blocking, call this after the handle was reported readable by a poll.
+    /// Returns true if there was a permit.
+    bool consume();
+
+    /// Returns the handle that becomes readable (on Windows, signaled) while a permit is stored.
+    NativeHandle nativeHandle() const noexcept;
+
+private:
+#ifdef ASP_IS_WIN
+    void* m_event;
+#else
+    int m_readFd = -1;
+    int m_writeFd = -1;
+#endif
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,209 @@
+#pragma once
+#include "../detail/config.hpp"
+#include <asp/detail/Result.hpp>
+#include <asp/data/nums.hpp>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace asp {
+
+namespace detail {
+
+/// The initialization state machine shared by `OnceCell` and `LazyLock`.
+class OnceState {
+public:
+    bool isComplete() const noexcept {
+        return m_state.load(std::memory_order::acquire) == COMPLETE;
+    }
+
+    /// Returns true if the caller should run the initializer, in which case it must later call `complete` or `abort`.
+    /// Returns false if the value is already initialized. If another thread is initializing, parks until it finishes.
+    bool begin() noexcept;
+
+    void complete() noexcept {
+        this->finish(COMPLETE);
+    }
+
+    /// Resets the state after a failed initialization, so that another caller can retry.
+    void abort() noexcept {
+        this->finish(UNINIT);
+    }
+
+private:
+    static constexpr u8 UNINIT = 0;
+    static constexpr u8 RUNNING = 1;
+    // running, and somebody is parked waiting for it to finish
+    static constexpr u8 RUNNING_WAITERS = 2;
+    static constexpr u8 COMPLETE = 3;
+
+    std::atomic<u8> m_state{UNINIT};
+
+    void finish(u8 state) noexcept;
+};
+
+template <typename R>
+struct ResultErrType;
+
+template <typename T, typename E>
+struct ResultErrType<Result<T, E>> {
+    using type = E;
+};
+
+}
+
+/// A cell that is written at most once, typically lazily from whichever thread needs the value first.
+/// Once initialized, reading is a single acquire load. Threads that race with an initialization in progress
+/// park until it completes instead of spinning. If the initializer fails, the cell stays empty and the next caller retries.
+template <typename T>
+class OnceCell {
+public:
+    OnceCell() = default;
+
+    OnceCell(const OnceCell&) = delete;
+    OnceCell& operator=(const OnceCell&) = delete;
+    OnceCell(OnceCell&&) = delete;
+    OnceCell& operator=(OnceCell&&) = delete;
+
+    ~OnceCell() {
+        if (m_once.isComplete()) {
+            std::destroy_at(this->ptr());
+        }
+    }
+
+    /// Returns the value, or `nullptr` if the cell is not initialized yet.
+    T* get() noexcept {
+        return m_once.isComplete() ? this->ptr() : nullptr;
+    }
+
+    /// Returns the value, or `nullptr` if the cell is not initialized yet.
+    const T* get() const noexcept {
+        return m_once.isComplete() ? this->ptr() : nullptr;
+    }
+
+    bool isInitialized() const noexcept {
+        return m_once.isComplete();
+    }
+
+    /// Returns the value, initializing it with `f()` if the cell is empty.
+    /// If `f` throws, the exception propagates and the cell stays empty.
+    template <typename F>
+    T& getOrInit(F&& f) {
+        if (!m_once.isComplete()) [[unlikely]] {
+            this->initialize([&] { return f(); });
+        }
+
+        return *this->ptr();
+    }
+
+    /// Like `getOrInit`, but `f` returns a `Result<T, E>`. If it returns an error, the cell stays empty and the error is returned.
+    /// On success, the returned pointer is never null.
+    template <typename F, typename R = std::invoke_result_t<F>, typename E = typename detail::ResultErrType<R>::type>
+    Result<T*, E> getOrTryInit(F&& f) {
+        if (m_once.isComplete()) [[likely]] {
+            return Ok(this->ptr());
+        }
+
+        if (!m_once.begin()) {
+            return Ok(this->ptr());
+        }
+
+        AbortGuard guard{m_once};
+        auto result = f();
+
+        if (result.isErr()) {
+            return Err(std::move(result).unwrapErr());
+        }
+
+        std::construct_at(this->ptr(), std::move(result).unwrap());
+        guard.committed = true;
+        m_once.complete();
+
+        return Ok(this->ptr());
+    }
+
+    /// Initializes the cell with `value`. Returns false if it was already initialized, in which case `value` is discarded.
+    bool set(T value) {
+        bool initialized = false;
+
+        this->initialize([&] {
+            initialized = true;
+            return std::move(value);
+        });
+
+        return initialized;
+    }
+
+private:
+    detail::OnceState m_once;
+    alignas(T) unsigned char m_storage[sizeof(T)];
+
+    struct AbortGuard {
+        detail::OnceState& once;
+        bool committed = false;
+
+        ~AbortGuard() {
+            if (!committed) once.abort();
+        }
+    };
+
+    T* ptr() noexcept {
+        return std::launder(reinterpret_cast<T*>(m_storage));
+    }
+
+    const T* ptr() const noexcept {
+        return std::launder(reinterpret_cast<const T*>(m_storage));
+    }
+
+    template <typename F>
+    ASP_NOINLINE void initialize(F&& f) {
+        if (!m_once.begin()) return;
+
+        AbortGuard guard{m_once};
+        std::construct_at(this->ptr(), f());
+        guard.committed = true;
+
+        m_once.complete();
+    }
+};
+
+/// A value that is initialized by calling `F` on first access, from whichever thread gets there first.
+/// Useful for global tables, where it replaces function-local statics and mutex-guarded pointers.
+/// After initialization, every access is a single acquire load.
+template <typename T, typename F = T(*)()>
+class LazyLock {
+public:
+    LazyLock(F init) : m_init(std::move(init)) {}
+
+    LazyLock(const LazyLock&) = delete;
+    LazyLock& operator=(const LazyLock&) = delete;
+
+    /// Returns the value, initializing it if this is the first access.
+    T& get() const {
+        return m_cell.getOrInit(m_init);
+    }
+
+    T& operator*() const {
+        return this->get();
+    }
+
+    T* operator->() const {
+        return &this->get();
+    }
+
+    bool isInitialized() const noexcept {
+        return m_cell.isInitialized();
+    }
+
+private:
+    mutable OnceCell<T> m_cell;
+    mutable F m_init;
+};
+
+template <typename F>
+LazyLock(F) -> LazyLock<std::invoke_result_t<F&>, F>;
+
+}
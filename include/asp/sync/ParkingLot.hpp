@@ -0,0 +1,91 @@
+#pragma once
+#include "../detail/config.hpp"
+#include <asp/detail/Function.hpp>
+#include <asp/data/nums.hpp>
+#include <asp/time/Instant.hpp>
+
+/// A global table of wait queues keyed by address, in the style of WebKit's `ParkingLot`.
+/// Instead of embedding an OS mutex or a 4-byte futex word, a synchronization primitive can keep just a couple of bits of state
+/// (e.g. "locked" and "somebody is parked") and park threads in the shared table, using its own address as the key.
+/// This is what lets `asp::Mutex`, `asp::Notify` and `asp::OnceCell` get away with a single byte of state.
+///
+/// Keys are hashed into a fixed amount of buckets, each with its own small lock and an intrusive queue of parked threads.
+namespace asp::parking {
+
+/// Value handed from the unparking thread to the thread it unparks.
+using UnparkToken = usize;
+
+struct ParkResult {
+    enum Kind : u8 {
+        /// Woken up by `unparkOne` or `unparkAll`, `token` holds the value they passed.
+        Unparked,
+        /// The `validate` callback returned false, the thread never went to sleep.
+        Invalid,
+        /// The deadline was reached before anyone unparked the thread.
+        TimedOut,
+    };
+
+    Kind kind;
+    UnparkToken token = 0;
+};
+
+struct UnparkResult {
+    /// Amount of threads that were unparked.
+    u32 unparkedThreads = 0;
+    /// Amount of threads that were moved to another queue by `unparkRequeue`.
+    u32 requeuedThreads = 0;
+    /// Whether there are still threads parked on the same key.
+    bool haveMoreThreads = false;
+};
+
+/// What `unparkRequeue` should do, decided by its `validate` callback.
+enum class RequeueOp : u8 {
+    /// Do nothing.
+    Abort,
+    /// Unpark one thread and leave the rest parked on the original key.
+    UnparkOne,
+    /// Unpark one thread and move the rest to the new key.
+    UnparkOneRequeueRest,
+    /// Move one thread to the new key without unparking it.
+    RequeueOne,
+    /// Move all threads to the new key without unparking any.
+    RequeueAll,
+};
+
+/// Parks the current thread in the queue for `key`, until it is unparked or the deadline is reached.
+/// `validate` is called with the queue locked, right before parking, if it returns false the thread doesn't park.
+/// `beforeSleep` is called after the thread is enqueued and the queue is unlocked, right before it goes to sleep.
+/// `timedOut` is called with the queue locked if the deadline is reached. It receives the key the thread was parked on at that point
+/// (which differs from `key` if it was requeued), and whether this was the last thread parked on it.
+/// `validate` and `timedOut` must not park or unpark anything themselves.
+ParkResult park(
+    const void* key,
+    FunctionRef<bool()> validate,
+    FunctionRef<void()> beforeSleep,
+    FunctionRef<void(const void* key, bool wasLastThread)> timedOut,
+    const time::Instant& deadline = time::Instant::farFuture()
+);
+
+/// Like the other overload, for primitives that have nothing to do on timeout.
+ParkResult park(const void* key, FunctionRef<bool()> validate, const time::Instant& deadline = time::Instant::farFuture());
+
+/// Unparks the thread that has been parked on `key` the longest, if there is one.
+/// `callback` is called with the queue locked before the thread is woken up (even if there was nothing to unpark),
+/// which is where the primitive should update its state, and returns the token to hand over to the woken thread.
+UnparkResult unparkOne(const void* key, FunctionRef<UnparkToken(UnparkResult)> callback);
+
+/// Unparks all threads parked on `key`, handing each of them `token`. Returns the amount of unparked threads.
+usize unparkAll(const void* key, UnparkToken token = 0);
+
+/// Moves threads parked on `from` to the queue for `to`, optionally unparking one of them, without waking the rest up.
+/// This is how a condition variable hands its waiters straight to the mutex they will need next.
+/// Both queues are locked while `validate` picks the operation, and while `callback` runs before the thread is woken up,
+/// which returns the token for the unparked thread, if there is one.
+UnparkResult unparkRequeue(
+    const void* from,
+    const void* to,
+    FunctionRef<RequeueOp()> validate,
+    FunctionRef<UnparkToken(RequeueOp, UnparkResult)> callback
+);
+
+}
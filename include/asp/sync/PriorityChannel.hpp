@@ -0,0 +1,312 @@
+#pragma once
+#include <asp/collections/DaryHeap.hpp>
+#include <asp/time/Duration.hpp>
+#include <asp/time/Instant.hpp>
+#include <asp/time/chrono.hpp>
+#include <asp/data/nums.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include <stdexcept>
+#include <tuple>
+
+namespace asp {
+
+/// Thread-safe message queue that hands out messages in priority order instead of FIFO order.
+/// Like `std::priority_queue`, with the default `std::less` comparator the greatest message is popped first.
+template <typename T, typename Compare = std::less<T>>
+class PriorityChannel {
+public:
+    PriorityChannel() {}
+    PriorityChannel(Compare cmp) : heap(std::move(cmp)) {}
+
+    bool empty() const {
+        std::unique_lock lock(mtx);
+        return heap.empty();
+    }
+
+    size_t size() const {
+        std::unique_lock lock(mtx);
+        return heap.size();
+    }
+
+    // Obtains the message with the highest priority, if the channel is empty, blocks until there's data.
+    T pop() {
+        std::unique_lock lock(mtx);
+        cvar.wait(lock, [this] { return !heap.empty(); });
+
+        return heap.pop();
+    }
+
+    // Like `pop`, but will return `std::nullopt` if the given timeout expires before there's available data.
+    std::optional<T> popTimeout(const time::Duration& timeout) {
+        return popTimeout(time::toChrono<std::chrono::microseconds>(timeout));
+    }
+
+    // Like `pop`, but will return `std::nullopt` if the given timeout expires before there's available data.
+    template <typename Rep, typename Period>
+    std::optional<T> popTimeout(std::chrono::duration<Rep, Period> timeout) {
+        std::unique_lock lock(mtx);
+        if (!cvar.wait_for(lock, timeout, [this] { return !heap.empty(); })) {
+            return std::nullopt;
+        }
+
+        return std::optional<T>(heap.pop());
+    }
+
+    // Blocks until messages are available, does not actually pop any messages from the channel.
+    void waitForMessages(const time::Duration& timeout) {
+        waitForMessages(time::toChrono<std::chrono::microseconds>(timeout));
+    }
+
+    // Blocks until messages are available, does not actually pop any messages from the channel.
+    template <typename Rep, typename Period>
+    void waitForMessages(std::chrono::duration<Rep, Period> timeout) {
+        std::unique_lock lock(mtx);
+        cvar.wait_for(lock, timeout, [this] { return !heap.empty(); });
+    }
+
+    // Obtains the message with the highest priority, throws if the channel is empty.
+    T popNow() {
+        std::unique_lock lock(mtx);
+        if (heap.empty()) {
+            throw std::runtime_error("attempting to pop a message from an empty channel");
+        }
+
+        return heap.pop();
+    }
+
+    // Returns the message with the highest priority if present, otherwise returns `std::nullopt`.
+    std::optional<T> tryPop() {
+        std::unique_lock lock(mtx);
+        if (heap.empty()) return std::nullopt;
+
+        return heap.pop();
+    }
+
+    // Pops up to `max` messages in priority order without blocking.
+    std::vector<T> drain(size_t max = (size_t)-1) {
+        std::vector<T> out;
+
+        std::unique_lock lock(mtx);
+        out.reserve(std::min(max, heap.size()));
+        while (!heap.empty() && out.size() < max) {
+            out.push_back(heap.pop());
+        }
+
+        return out;
+    }
+
+    // Pushes a new message to the queue.
+    void push(const T& msg) {
+        std::unique_lock lock(mtx);
+        heap.push(msg);
+        cvar.notify_one();
+    }
+
+    // Pushes a new message to the queue.
+    void push(T&& msg) {
+        std::unique_lock lock(mtx);
+        heap.push(std::move(msg));
+        cvar.notify_one();
+    }
+
+    // Pushes all messages from the given range, taking the lock only once.
+    template <typename Range>
+    void pushAll(Range&& msgs) {
+        std::unique_lock lock(mtx);
+        size_t count = 0;
+
+        for (auto&& msg : msgs) {
+            heap.push(std::forward<decltype(msg)>(msg));
+            count++;
+        }
+
+        if (count == 1) {
+            cvar.notify_one();
+        } else if (count > 1) {
+            cvar.notify_all();
+        }
+    }
+
+private:
+    DaryHeap<T, 4, Compare> heap;
+    mutable std::mutex mtx;
+    std::condition_variable cvar;
+};
+
+/// Thread-safe message queue where every message carries a deadline, and is only handed out once that deadline is reached.
+/// Messages are popped in deadline order, messages with equal deadlines are popped in the order they were pushed.
+/// Receivers sleep exactly until the earliest deadline, and are woken up early if a message with an earlier deadline is pushed.
+template <typename T>
+class DeadlineChannel {
+public:
+    DeadlineChannel() {}
+
+    bool empty() const {
+        std::unique_lock lock(mtx);
+        return heap.empty();
+    }
+
+    // Returns the amount of messages in the channel, including ones that are not due yet.
+    size_t size() const {
+        std::unique_lock lock(mtx);
+        return heap.size();
+    }
+
+    // Returns the deadline of the earliest message, if there is one.
+    std::optional<Instant> nextDeadline() const {
+        std::unique_lock lock(mtx);
+        if (heap.empty()) return std::nullopt;
+
+        return heap.top().due;
+    }
+
+    // Obtains the earliest message, blocking until the channel has a message and its deadline is reached.
+    T pop() {
+        std::unique_lock lock(mtx);
+        this->waitDue(lock, Instant::farFuture());
+
+        return heap.pop().value;
+    }
+
+    // Like `pop`, but will return `std::nullopt` if the given timeout expires before a message is due.
+    std::optional<T> popTimeout(const time::Duration& timeout) {
+        auto expiry = Instant::now() + timeout;
+
+        std::unique_lock lock(mtx);
+        if (!this->waitDue(lock, expiry)) {
+            return std::nullopt;
+        }
+
+        return std::optional<T>(heap.pop().value);
+    }
+
+    // Blocks until a message is due, does not actually pop any messages from the channel.
+    void waitForMessages(const time::Duration& timeout) {
+        auto expiry = Instant::now() + timeout;
+
+        std::unique_lock lock(mtx);
+        if (this->waitDue(lock, expiry)) {
+            // we may have taken the wakeup meant for a receiver, pass it on since the message is still there
+            cvar.notify_one();
+        }
+    }
+
+    // Obtains the earliest message if it is due, throws if the channel is empty or no message is due yet.
+    T popNow() {
+        std::unique_lock lock(mtx);
+        if (heap.empty() || heap.top().due > Instant::now()) {
+            throw std::runtime_error("attempting to pop a message from an empty channel");
+        }
+
+        return heap.pop().value;
+    }
+
+    // Returns the earliest message if it is due, otherwise returns `std::nullopt`.
+    std::optional<T> tryPop() {
+        std::unique_lock lock(mtx);
+        if (heap.empty() || heap.top().due > Instant::now()) return std::nullopt;
+
+        return heap.pop().value;
+    }
+
+    // Pops up to `max` messages that are already due, without blocking.
+    std::vector<T> drain(size_t max = (size_t)-1) {
+        std::vector<T> out;
+        auto now = Instant::now();
+
+        std::unique_lock lock(mtx);
+        while (!heap.empty() && out.size() < max && heap.top().due <= now) {
+            out.push_back(heap.pop().value);
+        }
+
+        return out;
+    }
+
+    // Pushes a message that becomes available at `due`.
+    void push(const T& msg, Instant due) {
+        this->pushEntry(Entry{due, 0, msg});
+    }
+
+    // Pushes a message that becomes available at `due`.
+    void push(T&& msg, Instant due) {
+        this->pushEntry(Entry{due, 0, std::move(msg)});
+    }
+
+    // Pushes a message that becomes available after `delay`.
+    void pushAfter(T msg, const time::Duration& delay) {
+        this->push(std::move(msg), Instant::now() + delay);
+    }
+
+    // Pushes all (message, deadline) pairs from the given range, taking the lock only once.
+    template <typename Range>
+    void pushAll(Range&& msgs) {
+        std::unique_lock lock(mtx);
+
+        for (auto&& item : msgs) {
+            auto due = std::get<1>(item);
+            heap.push(Entry{due, nextSeq++, std::get<0>(std::forward<decltype(item)>(item))});
+        }
+
+        cvar.notify_all();
+    }
+
+private:
+    struct Entry {
+        Instant due;
+        u64 seq;
+        T value;
+    };
+
+    struct EntryCompare {
+        // inverted, so that the earliest deadline is at the top of the heap
+        bool operator()(const Entry& a, const Entry& b) const noexcept {
+            if (a.due != b.due) return a.due > b.due;
+            return a.seq > b.seq;
+        }
+    };
+
+    DaryHeap<Entry, 4, EntryCompare> heap;
+    u64 nextSeq = 0;
+    mutable std::mutex mtx;
+    std::condition_variable cvar;
+
+    void pushEntry(Entry&& entry) {
+        std::unique_lock lock(mtx);
+        entry.seq = nextSeq++;
+
+        heap.push(std::move(entry));
+
+        // wake a receiver so it can recompute how long it needs to sleep
+        cvar.notify_one();
+    }
+
+    // Waits until the earliest message is due. Returns false if `expiry` was reached first.
+    bool waitDue(std::unique_lock<std::mutex>& lock, Instant expiry) {
+        while (true) {
+            auto now = Instant::now();
+
+            if (!heap.empty() && heap.top().due <= now) {
+                return true;
+            }
+
+            if (now >= expiry) {
+                return false;
+            }
+
+            auto wakeAt = heap.empty() ? expiry : std::min(expiry, heap.top().due);
+
+            if (wakeAt == Instant::farFuture()) {
+                cvar.wait(lock);
+            } else {
+                cvar.wait_for(lock, time::toChrono<std::chrono::microseconds>(wakeAt.durationSince(now)) + std::chrono::microseconds(1));
+            }
+        }
+    }
+};
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "../detail/config.hpp"
+#include <asp/data/nums.hpp>
+#include <atomic>
+
+namespace asp {
+
+/// A 1-byte mutual exclusion lock, without any data attached to it.
+/// Uncontended locking and unlocking is a single atomic operation. Under contention,
+/// the lock spins for a short while (most critical sections are tiny), and then parks the thread in the global parking lot.
+/// Prefer `asp::Mutex<T>` which uses this under the hood.
+class RawMutex {
+public:
+    RawMutex() = default;
+
+    RawMutex(const RawMutex&) = delete;
+    RawMutex& operator=(const RawMutex&) = delete;
+    RawMutex(RawMutex&&) = delete;
+    RawMutex& operator=(RawMutex&&) = delete;
+
+    void lock() noexcept {
+        u8 expected = UNLOCKED;
+        if (!m_state.compare_exchange_strong(expected, LOCKED, std::memory_order::acquire, std::memory_order::relaxed)) [[unlikely]] {
+            this->lockSlow();
+        }
+    }
+
+    bool tryLock() noexcept {
+        u8 state = m_state.load(std::memory_order::relaxed);
+
+        while (!(state & LOCKED)) {
+            if (m_state.compare_exchange_weak(state, state | LOCKED, std::memory_order::acquire, std::memory_order::relaxed)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void unlock() noexcept {
+        u8 expected = LOCKED;
+        if (!m_state.compare_exchange_strong(expected, UNLOCKED, std::memory_order::release, std::memory_order::relaxed)) [[unlikely]] {
+            this->unlockSlow();
+        }
+    }
+
+    bool isLocked() const noexcept {
+        return (m_state.load(std::memory_order::relaxed) & LOCKED) != 0;
+    }
+
+    // std Lockable compatibility, allows using std::unique_lock / std::scoped_lock
+    bool try_lock() noexcept {
+        return this->tryLock();
+    }
+
+private:
+    friend class Condvar;
+
+    static constexpr u8 UNLOCKED = 0;
+    static constexpr u8 LOCKED = 1;
+    // there may be threads parked on this lock
+    static constexpr u8 PARKED = 2;
+
+    std::atomic<u8> m_state{UNLOCKED};
+
+    ASP_COLD void lockSlow() noexcept;
+    ASP_COLD void unlockSlow() noexcept;
+
+    // used by `Condvar` when requeueing its waiters onto this mutex, with the parking lot queue locked
+
+    bool markParkedIfLocked() noexcept {
+        u8 state = m_state.load(std::memory_order::relaxed);
+
+        while (state & LOCKED) {
+            if (m_state.compare_exchange_weak(state, state | PARKED, std::memory_order::relaxed, std::memory_order::relaxed)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void markParked() noexcept {
+        m_state.fetch_or(PARKED, std::memory_order::relaxed);
+    }
+};
+
+static_assert(sizeof(RawMutex) == 1);
+
+}
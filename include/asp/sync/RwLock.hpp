@@ -0,0 +1,330 @@
+#pragma once
+#include "../detail/config.hpp"
+#include "RawMutex.hpp"
+#include <asp/data/nums.hpp>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace asp {
+
+/// An 8-byte reader-writer lock, without any data attached to it.
+/// Writers are preferred: once a writer is waiting, new readers block until it is done, so writers can't be starved.
+/// Prefer `asp::RwLock<T>` which uses this under the hood.
+class RawRwLock {
+public:
+    struct ReadToken {};
+
+    RawRwLock() = default;
+
+    RawRwLock(const RawRwLock&) = delete;
+    RawRwLock& operator=(const RawRwLock&) = delete;
+    RawRwLock(RawRwLock&&) = delete;
+    RawRwLock& operator=(RawRwLock&&) = delete;
+
+    ReadToken lockShared() noexcept {
+        u32 state = m_state.load(std::memory_order::relaxed);
+        if (!isReadLockable(state) || !m_state.compare_exchange_weak(state, state + READ_LOCKED, std::memory_order::acquire, std::memory_order::relaxed)) [[unlikely]] {
+            this->lockSharedSlow();
+        }
+
+        return {};
+    }
+
+    bool tryLockShared() noexcept {
+        u32 state = m_state.load(std::memory_order::relaxed);
+        while (isReadLockable(state)) {
+            if (m_state.compare_exchange_weak(state, state + READ_LOCKED, std::memory_order::acquire, std::memory_order::relaxed)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void unlockShared(ReadToken = {}) noexcept {
+        u32 state = m_state.fetch_sub(READ_LOCKED, std::memory_order::release) - READ_LOCKED;
+
+        // readers only wait on a read locked lock if a writer is waiting as well
+        if (isUnlocked(state) && hasWritersWaiting(state)) [[unlikely]] {
+            this->wakeWriterOrReaders(state);
+        }
+    }
+
+    void lock() noexcept {
+        u32 expected = 0;
+        if (!m_state.compare_exchange_strong(expected, WRITE_LOCKED, std::memory_order::acquire, std::memory_order::relaxed)) [[unlikely]] {
+            this->lockSlow();
+        }
+    }
+
+    bool tryLock() noexcept {
+        u32 expected = 0;
+        return m_state.compare_exchange_strong(expected, WRITE_LOCKED, std::memory_order::acquire, std::memory_order::relaxed);
+    }
+
+    void unlock() noexcept {
+        u32 state = m_state.fetch_sub(WRITE_LOCKED, std::memory_order::release) - WRITE_LOCKED;
+
+        if (hasWritersWaiting(state) || hasReadersWaiting(state)) [[unlikely]] {
+            this->wakeWriterOrReaders(state);
+        }
+    }
+
+private:
+    // the lower 30 bits hold the amount of readers, or all ones if write locked
+    static constexpr u32 READ_LOCKED = 1;
+    static constexpr u32 MASK = (1u << 30) - 1;
+    static constexpr u32 WRITE_LOCKED = MASK;
+    static constexpr u32 MAX_READERS = MASK - 1;
+    static constexpr u32 READERS_WAITING = 1u << 30;
+    static constexpr u32 WRITERS_WAITING = 1u << 31;
+
+    std::atomic<u32> m_state{0};
+    // bumped every time a writer is woken up, writers sleep on this instead of the state
+    std::atomic<u32> m_writerNotify{0};
+
+    static bool isUnlocked(u32 state) noexcept { return (state & MASK) == 0; }
+    static bool isWriteLocked(u32 state) noexcept { return (state & MASK) == WRITE_LOCKED; }
+    static bool hasReadersWaiting(u32 state) noexcept { return (state & READERS_WAITING) != 0; }
+    static bool hasWritersWaiting(u32 state) noexcept { return (state & WRITERS_WAITING) != 0; }
+
+    static bool isReadLockable(u32 state) noexcept {
+        // readers are not allowed in if anyone is waiting, this is what gives writers preference
+        return (state & MASK) < MAX_READERS && !hasReadersWaiting(state) && !hasWritersWaiting(state);
+    }
+
+    ASP_COLD void lockSharedSlow() noexcept;
+    ASP_COLD void lockSlow() noexcept;
+    ASP_COLD void wakeWriterOrReaders(u32 state) noexcept;
+    bool wakeWriter() noexcept;
+    template <typename F>
+    u32 spinUntil(F&& f) noexcept;
+};
+
+/// A reader-writer lock that keeps reader counts in per-CPU slots, each on its own cache line.
+/// Concurrent readers on different cores never write to the same memory, so read locking scales with the core count,
+/// at the cost of writers having to check every slot. Writers are preferred, like in `RawRwLock`.
+/// Prefer `asp::ShardedRwLock<T>` which uses this under the hood.
+class RawShardedRwLock {
+public:
+    struct ReadToken {
+        u32 slot = 0;
+    };
+
+    RawShardedRwLock();
+
+    RawShardedRwLock(const RawShardedRwLock&) = delete;
+    RawShardedRwLock& operator=(const RawShardedRwLock&) = delete;
+    RawShardedRwLock(RawShardedRwLock&&) = delete;
+    RawShardedRwLock& operator=(RawShardedRwLock&&) = delete;
+
+    ReadToken lockShared() noexcept;
+    /// Returns the token to unlock with, or nothing if a writer holds or is acquiring the lock.
+    std::optional<ReadToken> tryLockShared() noexcept;
+
+    void unlockShared(ReadToken token) noexcept {
+        auto& slot = m_slots[token.slot].readers;
+
+        // seq_cst pairs with the writer setting the flag and then checking the slots
+        if (slot.fetch_sub(1, std::memory_order::seq_cst) == 1 && m_writer.load(std::memory_order::seq_cst) != 0) [[unlikely]] {
+            this->wakeSlot(token.slot);
+        }
+    }
+
+    void lock() noexcept;
+    bool tryLock() noexcept;
+    void unlock() noexcept;
+
+private:
+    struct alignas(ASP_CACHE_LINE_SIZE) Slot {
+        std::atomic<u32> readers{0};
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    u32 m_slotMask;
+    // nonzero while a writer holds or is acquiring the lock
+    std::atomic<u32> m_writer{0};
+    // serializes writers
+    RawMutex m_writerLock;
+
+    void wakeSlot(u32 slot) noexcept;
+    bool tryEnterSlot(u32 slot) noexcept;
+};
+
+template <typename T, typename Raw>
+class RwLock;
+
+template <typename T, typename Raw>
+class [[nodiscard("A lock guard must be stored in a variable to be effective")]] RwLockReadGuard {
+public:
+    RwLockReadGuard(const RwLockReadGuard&) = delete;
+    RwLockReadGuard& operator=(const RwLockReadGuard&) = delete;
+
+    RwLockReadGuard(const RwLock<T, Raw>& lock) : m_lock(&lock) {
+        this->relock();
+    }
+
+    RwLockReadGuard(RwLockReadGuard&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    RwLockReadGuard& operator=(RwLockReadGuard&& other) noexcept {
+        if (this != &other) {
+            this->unlock();
+
+            m_lock = std::exchange(other.m_lock, nullptr);
+            m_token = other.m_token;
+            m_locked = std::exchange(other.m_locked, false);
+        }
+        return *this;
+    }
+
+    ~RwLockReadGuard() {
+        this->unlock();
+    }
+
+    // Unlocks the lock. Any access to this `Guard` afterwards invokes undefined behavior,
+    // unless it is relocked again with `.relock()`.
+    void unlock() noexcept {
+        if (!m_locked) return;
+
+        m_lock->m_raw.unlockShared(m_token);
+        m_locked = false;
+    }
+
+    void relock() noexcept {
+        if (m_locked) return;
+
+        m_token = m_lock->m_raw.lockShared();
+        m_locked = true;
+    }
+
+    const T& operator*() const noexcept {
+        return m_lock->m_data;
+    }
+
+    const T* operator->() const noexcept {
+        return &m_lock->m_data;
+    }
+
+private:
+    const RwLock<T, Raw>* m_lock = nullptr;
+    typename Raw::ReadToken m_token{};
+    bool m_locked = false;
+};
+
+template <typename T, typename Raw>
+class [[nodiscard("A lock guard must be stored in a variable to be effective")]] RwLockWriteGuard {
+public:
+    RwLockWriteGuard(const RwLockWriteGuard&) = delete;
+    RwLockWriteGuard& operator=(const RwLockWriteGuard&) = delete;
+
+    RwLockWriteGuard(const RwLock<T, Raw>& lock) : m_lock(&lock) {
+        this->relock();
+    }
+
+    RwLockWriteGuard(RwLockWriteGuard&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    RwLockWriteGuard& operator=(RwLockWriteGuard&& other) noexcept {
+        if (this != &other) {
+            this->unlock();
+
+            m_lock = std::exchange(other.m_lock, nullptr);
+            m_locked = std::exchange(other.m_locked, false);
+        }
+        return *this;
+    }
+
+    ~RwLockWriteGuard() {
+        this->unlock();
+    }
+
+    // Unlocks the lock. Any access to this `Guard` afterwards invokes undefined behavior,
+    // unless it is relocked again with `.relock()`.
+    void unlock() noexcept {
+        if (!m_locked) return;
+
+        m_lock->m_raw.unlock();
+        m_locked = false;
+    }
+
+    void relock() noexcept {
+        if (m_locked) return;
+
+        m_lock->m_raw.lock();
+        m_locked = true;
+    }
+
+    T& operator*() noexcept {
+        return m_lock->m_data;
+    }
+
+    const T& operator*() const noexcept {
+        return m_lock->m_data;
+    }
+
+    T* operator->() noexcept {
+        return &m_lock->m_data;
+    }
+
+    const T* operator->() const noexcept {
+        return &m_lock->m_data;
+    }
+
+    RwLockWriteGuard& operator=(const T& other) {
+        m_lock->m_data = other;
+        return *this;
+    }
+
+    RwLockWriteGuard& operator=(T&& other) {
+        m_lock->m_data = std::move(other);
+        return *this;
+    }
+
+private:
+    const RwLock<T, Raw>* m_lock = nullptr;
+    bool m_locked = false;
+};
+
+/// A reader-writer lock protecting a value of type `T`. Any amount of readers can access the value at once,
+/// while writers get exclusive access. See `RawRwLock` for details about fairness.
+template <typename T, typename Raw = RawRwLock>
+class RwLock {
+public:
+    using ReadGuard = RwLockReadGuard<T, Raw>;
+    using WriteGuard = RwLockWriteGuard<T, Raw>;
+
+    template <typename... Args>
+    RwLock(Args&&... args) : m_data(std::forward<Args>(args)...) {}
+
+    RwLock(const RwLock&) = delete;
+    RwLock(RwLock&&) = delete;
+    RwLock& operator=(const RwLock&) = delete;
+    RwLock& operator=(RwLock&&) = delete;
+
+    ReadGuard read() const {
+        return ReadGuard(*this);
+    }
+
+    WriteGuard write() const {
+        return WriteGuard(*this);
+    }
+
+private:
+    friend class RwLockReadGuard<T, Raw>;
+    friend class RwLockWriteGuard<T, Raw>;
+
+    mutable Raw m_raw;
+    mutable T m_data;
+};
+
+/// A reader-writer lock with per-CPU reader counts, see `RawShardedRwLock`.
+/// Use it for read-mostly data that is read from many threads at once.
+template <typename T>
+using ShardedRwLock = RwLock<T, RawShardedRwLock>;
+
+}
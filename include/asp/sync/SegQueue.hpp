@@ -0,0 +1,328 @@
+#pragma once
+#include "../detail/config.hpp"
+#include "Backoff.hpp"
+#include <asp/data/nums.hpp>
+
+#include <atomic>
+#include <optional>
+#include <utility>
+#include <new>
+
+namespace asp {
+
+/// Unbounded lock-free multi-producer multi-consumer queue.
+/// Elements are stored in a linked list of fixed-size blocks, each slot has its own state,
+/// so producers and consumers only contend on the head and tail indices, never on a lock.
+/// Fully consumed blocks are recycled instead of being handed back to the allocator right away.
+template <typename T>
+class SegQueue {
+    static constexpr usize WRITE = 1;
+    static constexpr usize READ = 2;
+    static constexpr usize DESTROY = 4;
+
+    // each lap has one extra index which marks the end of a block
+    static constexpr usize LAP = 32;
+    static constexpr usize BLOCK_CAP = LAP - 1;
+
+    // the lowest bit of the head index is set if the head block has a successor
+    static constexpr usize SHIFT = 1;
+    static constexpr usize HAS_NEXT = 1;
+
+    struct Slot {
+        alignas(T) unsigned char value[sizeof(T)];
+        std::atomic<usize> state{0};
+
+        T* ptr() noexcept {
+            return std::launder(reinterpret_cast<T*>(value));
+        }
+
+        void waitWrite() noexcept {
+            Backoff backoff;
+            while ((state.load(std::memory_order::acquire) & WRITE) == 0) {
+                backoff.snooze();
+            }
+        }
+    };
+
+    struct Block {
+        std::atomic<Block*> next{nullptr};
+        Slot slots[BLOCK_CAP];
+
+        Block* waitNext() noexcept {
+            Backoff backoff;
+            while (true) {
+                auto n = next.load(std::memory_order::acquire);
+                if (n) return n;
+                backoff.snooze();
+            }
+        }
+    };
+
+    struct alignas(ASP_CACHE_LINE_SIZE) Position {
+        std::atomic<usize> index{0};
+        std::atomic<Block*> block{nullptr};
+    };
+
+public:
+    SegQueue() = default;
+
+    SegQueue(const SegQueue&) = delete;
+    SegQueue& operator=(const SegQueue&) = delete;
+    SegQueue(SegQueue&&) = delete;
+    SegQueue& operator=(SegQueue&&) = delete;
+
+    ~SegQueue() {
+        usize head = m_head.index.load(std::memory_order::relaxed) & ~((usize(1) << SHIFT) - 1);
+        usize tail = m_tail.index.load(std::memory_order::relaxed) & ~((usize(1) << SHIFT) - 1);
+        Block* block = m_head.block.load(std::memory_order::relaxed);
+
+        while (head != tail) {
+            usize offset = (head >> SHIFT) % LAP;
+
+            if (offset < BLOCK_CAP) {
+                block->slots[offset].ptr()->~T();
+            } else {
+                Block* next = block->next.load(std::memory_order::relaxed);
+                delete block;
+                block = next;
+            }
+
+            head += (usize(1) << SHIFT);
+        }
+
+        delete block;
+        delete m_spare.load(std::memory_order::relaxed);
+    }
+
+    void push(const T& value) {
+        this->push(T(value));
+    }
+
+    void push(T&& value) {
+        Backoff backoff;
+        usize tail = m_tail.index.load(std::memory_order::acquire);
+        Block* block = m_tail.block.load(std::memory_order::acquire);
+        Block* nextBlock = nullptr;
+
+        while (true) {
+            usize offset = (tail >> SHIFT) % LAP;
+
+            // another thread is installing the next block, wait for it
+            if (offset == BLOCK_CAP) {
+                backoff.snooze();
+                tail = m_tail.index.load(std::memory_order::acquire);
+                block = m_tail.block.load(std::memory_order::acquire);
+                continue;
+            }
+
+            // we are about to fill the block, preallocate the next one outside of the critical window
+            if (offset + 1 == BLOCK_CAP && !nextBlock) {
+                nextBlock = this->allocBlock();
+            }
+
+            // first push into the queue, install the first block
+            if (!block) {
+                Block* newBlock = nextBlock ? std::exchange(nextBlock, nullptr) : this->allocBlock();
+
+                if (m_tail.block.compare_exchange_strong(block, newBlock, std::memory_order::release, std::memory_order::relaxed)) {
+                    m_head.block.store(newBlock, std::memory_order::release);
+                    block = newBlock;
+                } else {
+                    nextBlock = newBlock;
+                    tail = m_tail.index.load(std::memory_order::acquire);
+                    block = m_tail.block.load(std::memory_order::acquire);
+                    continue;
+                }
+            }
+
+            usize newTail = tail + (usize(1) << SHIFT);
+
+            if (m_tail.index.compare_exchange_weak(tail, newTail, std::memory_order::seq_cst, std::memory_order::acquire)) {
+                if (offset + 1 == BLOCK_CAP) {
+                    // we took the last slot, link in the next block
+                    usize nextIndex = newTail + (usize(1) << SHIFT);
+                    Block* next = std::exchange(nextBlock, nullptr);
+
+                    m_tail.block.store(next, std::memory_order::release);
+                    m_tail.index.store(nextIndex, std::memory_order::release);
+                    block->next.store(next, std::memory_order::release);
+                }
+
+                if (nextBlock) {
+                    this->recycleBlock(nextBlock);
+                }
+
+                Slot& slot = block->slots[offset];
+                new (slot.value) T(std::move(value));
+                slot.state.fetch_or(WRITE, std::memory_order::release);
+                return;
+            }
+
+            // `tail` was updated by the failed CAS
+            block = m_tail.block.load(std::memory_order::acquire);
+            backoff.spin();
+        }
+    }
+
+    /// Pops an element from the front of the queue, returns `std::nullopt` if the queue is empty.
+    std::optional<T> pop() {
+        Backoff backoff;
+        usize head = m_head.index.load(std::memory_order::acquire);
+        Block* block = m_head.block.load(std::memory_order::acquire);
+
+        while (true) {
+            usize offset = (head >> SHIFT) % LAP;
+
+            // another thread is moving to the next block, wait for it
+            if (offset == BLOCK_CAP) {
+                backoff.snooze();
+                head = m_head.index.load(std::memory_order::acquire);
+                block = m_head.block.load(std::memory_order::acquire);
+                continue;
+            }
+
+            usize newHead = head + (usize(1) << SHIFT);
+
+            if ((newHead & HAS_NEXT) == 0) {
+                std::atomic_thread_fence(std::memory_order::seq_cst);
+                usize tail = m_tail.index.load(std::memory_order::relaxed);
+
+                if ((head >> SHIFT) == (tail >> SHIFT)) {
+                    return std::nullopt;
+                }
+
+                // head and tail are in different blocks, so the head block has a successor
+                if ((head >> SHIFT) / LAP != (tail >> SHIFT) / LAP) {
+                    newHead |= HAS_NEXT;
+                }
+            }
+
+            // the first block is still being installed
+            if (!block) {
+                backoff.snooze();
+                head = m_head.index.load(std::memory_order::acquire);
+                block = m_head.block.load(std::memory_order::acquire);
+                continue;
+            }
+
+            if (m_head.index.compare_exchange_weak(head, newHead, std::memory_order::seq_cst, std::memory_order::acquire)) {
+                if (offset + 1 == BLOCK_CAP) {
+                    // we took the last slot, move on to the next block
+                    Block* next = block->waitNext();
+                    usize nextIndex = (newHead & ~HAS_NEXT) + (usize(1) << SHIFT);
+                    if (next->next.load(std::memory_order::relaxed)) {
+                        nextIndex |= HAS_NEXT;
+                    }
+
+                    m_head.block.store(next, std::memory_order::release);
+                    m_head.index.store(nextIndex, std::memory_order::release);
+                }
+
+                Slot& slot = block->slots[offset];
+                slot.waitWrite();
+
+                T* ptr = slot.ptr();
+                std::optional<T> value{std::move(*ptr)};
+                ptr->~T();
+
+                if (offset + 1 == BLOCK_CAP) {
+                    this->destroyBlock(block, 0);
+                } else if (slot.state.fetch_or(READ, std::memory_order::acq_rel) & DESTROY) {
+                    this->destroyBlock(block, offset + 1);
+                }
+
+                return value;
+            }
+
+            // `head` was updated by the failed CAS
+            block = m_head.block.load(std::memory_order::acquire);
+            backoff.spin();
+        }
+    }
+
+    bool empty() const noexcept {
+        usize head = m_head.index.load(std::memory_order::seq_cst);
+        usize tail = m_tail.index.load(std::memory_order::seq_cst);
+        return (head >> SHIFT) == (tail >> SHIFT);
+    }
+
+    /// Returns the amount of elements in the queue. If the queue is concurrently modified, this is only an approximation.
+    usize size() const noexcept {
+        while (true) {
+            usize tail = m_tail.index.load(std::memory_order::seq_cst);
+            usize head = m_head.index.load(std::memory_order::seq_cst);
+
+            // retry if the tail moved in the meantime, to get a consistent snapshot
+            if (m_tail.index.load(std::memory_order::seq_cst) != tail) {
+                continue;
+            }
+
+            tail &= ~((usize(1) << SHIFT) - 1);
+            head &= ~((usize(1) << SHIFT) - 1);
+
+            // fix up indices that point at the end of a block
+            if (((tail >> SHIFT) & (LAP - 1)) == LAP - 1) {
+                tail += (usize(1) << SHIFT);
+            }
+            if (((head >> SHIFT) & (LAP - 1)) == LAP - 1) {
+                head += (usize(1) << SHIFT);
+            }
+
+            // rotate indices so that head falls into the first block
+            usize lap = (head >> SHIFT) / LAP;
+            tail -= (lap * LAP) << SHIFT;
+            head -= (lap * LAP) << SHIFT;
+
+            tail >>= SHIFT;
+            head >>= SHIFT;
+
+            // skip the end-of-block indices
+            return tail - head - tail / LAP;
+        }
+    }
+
+private:
+    Position m_head;
+    Position m_tail;
+    // a single cached block, reused instead of allocating a new one
+    std::atomic<Block*> m_spare{nullptr};
+
+    Block* allocBlock() {
+        if (Block* block = m_spare.exchange(nullptr, std::memory_order::acquire)) {
+            return block;
+        }
+
+        return new Block();
+    }
+
+    void recycleBlock(Block* block) noexcept {
+        block->next.store(nullptr, std::memory_order::relaxed);
+        for (auto& slot : block->slots) {
+            slot.state.store(0, std::memory_order::relaxed);
+        }
+
+        Block* expected = nullptr;
+        if (!m_spare.compare_exchange_strong(expected, block, std::memory_order::release, std::memory_order::relaxed)) {
+            delete block;
+        }
+    }
+
+    /// Destroys the block, starting at `start` checks that no other thread is still reading a slot.
+    /// If one is, it will be marked for destruction and the reader will continue destruction once it is done.
+    void destroyBlock(Block* block, usize start) noexcept {
+        // the last slot is skipped, as whoever reads it is the one that starts destruction
+        for (usize i = start; i < BLOCK_CAP - 1; i++) {
+            Slot& slot = block->slots[i];
+
+            if ((slot.state.load(std::memory_order::acquire) & READ) == 0
+                && (slot.state.fetch_or(DESTROY, std::memory_order::acq_rel) & READ) == 0)
+            {
+                return;
+            }
+        }
+
+        this->recycleBlock(block);
+    }
+};
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "../detail/config.hpp"
+#include <asp/data/nums.hpp>
+#include <asp/time/Duration.hpp>
+#include <asp/time/Instant.hpp>
+#include <atomic>
+
+namespace asp {
+
+/// A counting semaphore. `acquire` takes a permit, blocking until one is available, `release` gives permits back.
+/// Acquiring and releasing without contention is a single atomic operation, the waiter bookkeeping is only touched when a thread has to sleep.
+class Semaphore {
+public:
+    Semaphore(u32 permits = 0) : m_permits(permits) {}
+
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+    Semaphore(Semaphore&&) = delete;
+    Semaphore& operator=(Semaphore&&) = delete;
+
+    /// Takes a permit, blocking until one is available.
+    void acquire() noexcept {
+        if (!this->tryAcquire()) [[unlikely]] {
+            this->acquireSlow(Instant::farFuture());
+        }
+    }
+
+    /// Takes a permit, blocking until one is available or the timeout expires.
+    /// Returns false if the timeout expired.
+    bool acquire(const time::Duration& timeout) noexcept {
+        return this->tryAcquire() || this->acquireSlow(Instant::now() + timeout);
+    }
+
+    /// Takes a permit, blocking until one is available or the deadline is reached.
+    /// Returns false if the deadline was reached.
+    bool acquireUntil(const time::Instant& deadline) noexcept {
+        return this->tryAcquire() || this->acquireSlow(deadline);
+    }
+
+    /// Takes a permit if one is available, without blocking.
+    bool tryAcquire() noexcept {
+        u32 permits = m_permits.load(std::memory_order::relaxed);
+
+        while (permits > 0) {
+            if (m_permits.compare_exchange_weak(permits, permits - 1, std::memory_order::acquire, std::memory_order::relaxed)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// Gives `count` permits back, waking up to `count` waiting threads.
+    void release(u32 count = 1) noexcept;
+
+    /// Returns the amount of permits currently available.
+    u32 available() const noexcept {
+        return m_permits.load(std::memory_order::relaxed);
+    }
+
+private:
+    std::atomic<u32> m_permits;
+    std::atomic<u32> m_waiters{0};
+
+    ASP_COLD bool acquireSlow(const time::Instant& deadline) noexcept;
+};
+
+}
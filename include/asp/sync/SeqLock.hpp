@@ -0,0 +1,127 @@
+#pragma once
+#include "../detail/config.hpp"
+#include "Backoff.hpp"
+#include <asp/data/nums.hpp>
+
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+
+namespace asp {
+
+/// A sequence lock, for small trivially copyable values written by one thread and read by many.
+/// Readers never write to shared memory, they copy the value out and retry if a write happened concurrently.
+/// Writing is wait-free, but there must only ever be one writer at a time, use an external lock if there are multiple.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock<T> requires a trivially copyable T");
+
+    // the value is stored as relaxed atomic words, so that concurrent reads and writes are not data races
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(usize) - 1) / sizeof(usize);
+
+public:
+    SeqLock() : SeqLock(T{}) {}
+
+    SeqLock(const T& value) {
+        this->writeWords(value);
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+    SeqLock(SeqLock&&) = delete;
+    SeqLock& operator=(SeqLock&&) = delete;
+
+    /// Returns a consistent copy of the value, retrying as long as a write is in progress.
+    T load() const noexcept {
+        while (true) {
+            if (auto val = this->tryLoad()) {
+                return *val;
+            }
+
+            cpuRelax();
+        }
+    }
+
+    /// Makes a single attempt at reading the value, returns `std::nullopt` if it raced with a write.
+    std::optional<T> tryLoad() const noexcept {
+        usize seq1 = m_seq.load(std::memory_order::acquire);
+
+        // odd sequence means a write is in progress
+        if (seq1 & 1) {
+            return std::nullopt;
+        }
+
+        usize buf[WORDS];
+        for (size_t i = 0; i < WORDS; i++) {
+            buf[i] = m_words[i].load(std::memory_order::relaxed);
+        }
+
+        // make sure the data loads are not reordered past the second sequence load
+        std::atomic_thread_fence(std::memory_order::acquire);
+
+        if (m_seq.load(std::memory_order::relaxed) != seq1) {
+            return std::nullopt;
+        }
+
+        return fromWords(buf);
+    }
+
+    /// Replaces the value. Must not be called concurrently with another `store` or `update`.
+    void store(const T& value) noexcept {
+        usize seq = m_seq.load(std::memory_order::relaxed);
+        m_seq.store(seq + 1, std::memory_order::relaxed);
+
+        // make sure the odd sequence is visible before any of the data stores
+        std::atomic_thread_fence(std::memory_order::release);
+
+        this->writeWords(value);
+
+        m_seq.store(seq + 2, std::memory_order::release);
+    }
+
+    /// Reads the current value, passes it to `f` for modification and stores it back.
+    /// Like `store`, this must only be called from the writer thread. Since there is only one writer, the read never retries.
+    template <typename F>
+    void update(F&& f) noexcept(noexcept(f(std::declval<T&>()))) {
+        usize buf[WORDS];
+        for (size_t i = 0; i < WORDS; i++) {
+            buf[i] = m_words[i].load(std::memory_order::relaxed);
+        }
+
+        T value = fromWords(buf);
+        f(value);
+        this->store(value);
+    }
+
+    /// Returns the current sequence number, which is incremented by 2 on every write.
+    usize version() const noexcept {
+        return m_seq.load(std::memory_order::acquire);
+    }
+
+private:
+    alignas(ASP_CACHE_LINE_SIZE) std::atomic<usize> m_seq{0};
+    std::atomic<usize> m_words[WORDS];
+
+    static T fromWords(const usize* buf) noexcept {
+        // goes through a byte array, so that T does not need to be default constructible
+        struct Bytes {
+            alignas(T) unsigned char data[sizeof(T)];
+        } bytes;
+
+        std::memcpy(bytes.data, buf, sizeof(T));
+        return std::bit_cast<T>(bytes);
+    }
+
+    void writeWords(const T& value) noexcept {
+        usize buf[WORDS] = {};
+        std::memcpy(buf, &value, sizeof(T));
+
+        for (size_t i = 0; i < WORDS; i++) {
+            m_words[i].store(buf[i], std::memory_order::relaxed);
+        }
+    }
+};
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "../detail/config.hpp"
+#include <asp/data/nums.hpp>
+#include <atomic>
+#include <memory>
+
+namespace asp {
+
+/// A counter for statistics that are updated from many threads at once, but read rarely.
+/// Instead of one atomic that every core fights over, it keeps a slot per CPU, each on its own cache line,
+/// and sums them up when read. Updates are a single relaxed atomic add to (usually) uncontended memory.
+///
+/// The result of `load` is not a snapshot, updates that race with it may or may not be counted.
+/// Don't use this for counts that have to be exact at a specific moment, like "is all work done", use a `WaitGroup` for that instead.
+class ShardedCounter {
+public:
+    ShardedCounter();
+
+    ShardedCounter(const ShardedCounter&) = delete;
+    ShardedCounter& operator=(const ShardedCounter&) = delete;
+    ShardedCounter(ShardedCounter&&) = delete;
+    ShardedCounter& operator=(ShardedCounter&&) = delete;
+
+    void add(i64 n = 1) noexcept;
+
+    void sub(i64 n = 1) noexcept {
+        this->add(-n);
+    }
+
+    /// Returns the sum of all slots.
+    i64 load() const noexcept;
+
+    /// Resets all slots to zero. Updates that race with this may survive.
+    void reset() noexcept;
+
+private:
+    struct alignas(ASP_CACHE_LINE_SIZE) Slot {
+        std::atomic<i64> value{0};
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    u32 m_slotMask;
+};
+
+}
@@ -1,12 +1,12 @@
 #pragma once
 #include "../detail/config.hpp"
+#include "Backoff.hpp"
+#include "LockProfiler.hpp"
+#include <atomic>
+#include <type_traits>
 #include <utility>
 #include <stdint.h>
 
-#ifdef ASP_IS_X86
-# include <immintrin.h>
-#endif
-
 #if defined(_MSC_VER)
 # include <intrin.h>
 #endif
@@ -15,18 +15,13 @@ namespace asp {
 
 #if !defined(_MSC_VER)
 
-void ASP_FORCE_INLINE inline acquireAtomicLock(volatile uint8_t* ptr) {
+inline bool tryAcquireAtomicLock(volatile uint8_t* ptr) {
     uint8_t expected = 0;
+    return __atomic_compare_exchange_n(ptr, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
 
-    while (!__atomic_compare_exchange_n(ptr, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
-        expected = 0;
-
-#ifdef ASP_IS_X86
-        _mm_pause();
-#else
-        __asm__ __volatile__("yield");
-#endif
-    }
+inline bool isAtomicLockHeld(volatile uint8_t* ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_RELAXED) != 0;
 }
 
 void ASP_FORCE_INLINE inline releaseAtomicLock(volatile uint8_t* obj) {
@@ -35,15 +30,12 @@ void ASP_FORCE_INLINE inline releaseAtomicLock(volatile uint8_t* obj) {
 
 #else
 
-void ASP_FORCE_INLINE inline acquireAtomicLock(volatile uint8_t* ptr) {
-    while (true) {
-        if (_InterlockedCompareExchange8((volatile char*)ptr, 1, 0) == 0) {
-            return;
-        }
+inline bool tryAcquireAtomicLock(volatile uint8_t* ptr) {
+    return _InterlockedCompareExchange8((volatile char*)ptr, 1, 0) == 0;
+}
 
-        // spin
-        _mm_pause();
-    }
+inline bool isAtomicLockHeld(volatile uint8_t* ptr) {
+    return *ptr != 0;
 }
 
 void ASP_FORCE_INLINE inline releaseAtomicLock(volatile uint8_t* obj) {
@@ -53,7 +45,32 @@ void ASP_FORCE_INLINE inline releaseAtomicLock(volatile uint8_t* obj) {
 
 #endif
 
-template <typename T>
+ASP_NOINLINE inline void acquireAtomicLockSlow(volatile uint8_t* ptr) {
+    Backoff backoff;
+
+    while (true) {
+        // test-and-test-and-set: wait with plain loads, which keep the cache line shared,
+        // and only attempt the read-for-ownership once the lock looks free
+        while (isAtomicLockHeld(ptr)) {
+            cpuRelax();
+        }
+
+        if (tryAcquireAtomicLock(ptr)) {
+            return;
+        }
+
+        // lost the race to another waiter, back off to reduce the amount of threads that retry at once
+        backoff.spin();
+    }
+}
+
+void ASP_FORCE_INLINE inline acquireAtomicLock(volatile uint8_t* ptr) {
+    if (!tryAcquireAtomicLock(ptr)) [[unlikely]] {
+        acquireAtomicLockSlow(ptr);
+    }
+}
+
+template <typename T, typename Policy>
 class Channel;
 
 template <typename Inner = void>
@@ -74,9 +91,15 @@ public:
         Guard(const Guard&) = delete;
         Guard& operator=(const Guard&) = delete;
 
+#ifdef ASP_LOCK_PROFILING
+        Guard(const SpinLock& mtx, std::source_location loc = std::source_location::current()) noexcept : mtx(mtx) {
+            this->lockProfiled(loc);
+        }
+#else
         Guard(const SpinLock& mtx) noexcept : mtx(mtx) {
             mtx._lock();
         }
+#endif
 
         inline ~Guard() noexcept {
             this->unlock();
@@ -86,6 +109,9 @@ public:
         // unless it is relocked again with `.relock()`.
         inline void unlock() noexcept {
             if (!alreadyUnlocked) {
+#ifdef ASP_LOCK_PROFILING
+                probe.release();
+#endif
                 mtx._unlock();
 
                 alreadyUnlocked = true;
@@ -94,12 +120,21 @@ public:
 
         // Relocks the mutex after being unlocked with `unlock()`.
         // If the mutex was already locked, this does nothing.
+#ifdef ASP_LOCK_PROFILING
+        inline void relock(std::source_location loc = std::source_location::current()) noexcept {
+            if (alreadyUnlocked) {
+                this->lockProfiled(loc);
+                alreadyUnlocked = false;
+            }
+        }
+#else
         inline void relock() noexcept {
             if (alreadyUnlocked) {
                 mtx._lock();
                 alreadyUnlocked = false;
             }
         }
+#endif
 
         Inner& operator*() {
             return mtx.data;
@@ -129,16 +164,29 @@ public:
     private:
         const SpinLock& mtx;
         bool alreadyUnlocked = false;
+#ifdef ASP_LOCK_PROFILING
+        lockprof::Probe probe;
+
+        void lockProfiled(const std::source_location& loc) noexcept {
+            probe.acquire(loc, [this] { return tryAcquireAtomicLock(&mtx.mtx); }, [this] { mtx._lock(); });
+        }
+#endif
     };
 
+#ifdef ASP_LOCK_PROFILING
+    Guard lock(std::source_location loc = std::source_location::current()) const noexcept {
+        return Guard(*this, loc);
+    }
+#else
     Guard lock() const noexcept {
         return Guard(*this);
     }
+#endif
 
 private:
     friend class Guard;
 
-    template <typename T>
+    template <typename T, typename P>
     friend class Channel;
 
     mutable Inner data;
@@ -167,9 +215,15 @@ public:
 
     class Guard {
     public:
+#ifdef ASP_LOCK_PROFILING
+        inline Guard(const SpinLock& mtx, std::source_location loc = std::source_location::current()) noexcept : mtx(mtx) {
+            this->lockProfiled(loc);
+        }
+#else
         inline Guard(const SpinLock& mtx) noexcept : mtx(mtx) {
             mtx._lock();
         }
+#endif
 
         inline ~Guard() noexcept {
             this->unlock();
@@ -179,6 +233,9 @@ public:
         // unless it is relocked again with `.relock()`.
         inline void unlock() noexcept {
             if (!alreadyUnlocked) {
+#ifdef ASP_LOCK_PROFILING
+                probe.release();
+#endif
                 mtx._unlock();
                 alreadyUnlocked = true;
             }
@@ -186,23 +243,45 @@ public:
 
         // Relocks the mutex after being unlocked with `unlock()`.
         // If the mutex was already locked, this does nothing.
+#ifdef ASP_LOCK_PROFILING
+        inline void relock(std::source_location loc = std::source_location::current()) noexcept {
+            if (alreadyUnlocked) {
+                this->lockProfiled(loc);
+                alreadyUnlocked = false;
+            }
+        }
+#else
         inline void relock() noexcept {
             if (alreadyUnlocked) {
                 mtx._lock();
                 alreadyUnlocked = false;
             }
         }
+#endif
 
         Guard(const Guard&) = delete;
         Guard& operator=(const Guard&) = delete;
     private:
         const SpinLock& mtx;
         bool alreadyUnlocked = false;
+#ifdef ASP_LOCK_PROFILING
+        lockprof::Probe probe;
+
+        void lockProfiled(const std::source_location& loc) noexcept {
+            probe.acquire(loc, [this] { return tryAcquireAtomicLock(&mtx.mtx); }, [this] { mtx._lock(); });
+        }
+#endif
     };
 
+#ifdef ASP_LOCK_PROFILING
+    inline Guard lock(std::source_location loc = std::source_location::current()) const noexcept {
+        return Guard(*this, loc);
+    }
+#else
     inline Guard lock() const noexcept {
         return Guard(*this);
     }
+#endif
 private:
     mutable uint8_t mtx = 0;
 
@@ -218,4 +297,194 @@ private:
 template <typename T>
 using SpinLockGuard = typename SpinLock<T>::Guard;
 
-}
\ No newline at end of file
+/// Raw ticket lock. Waiters are served strictly in the order they arrived, and back off proportionally to their place in line.
+/// Occupies a full cache line, so that it never shares one with unrelated data.
+class alignas(ASP_CACHE_LINE_SIZE) RawTicketLock {
+public:
+    struct Node {};
+
+    void lock(Node&) noexcept {
+        uint32_t ticket = m_next.fetch_add(1, std::memory_order::relaxed);
+        Backoff backoff;
+
+        while (true) {
+            uint32_t serving = m_serving.load(std::memory_order::acquire);
+            if (serving == ticket) return;
+
+            // the further back in line, the longer we can wait before checking again
+            uint32_t distance = ticket - serving;
+            for (uint32_t i = 0; i < distance * 8; i++) {
+                cpuRelax();
+            }
+
+            // if the wait drags on, threads ahead of us were likely preempted, give them a chance to run
+            backoff.snooze();
+        }
+    }
+
+    bool tryLock(Node&) noexcept {
+        uint32_t serving = m_serving.load(std::memory_order::relaxed);
+        uint32_t expected = serving;
+        return m_next.compare_exchange_strong(expected, serving + 1, std::memory_order::acquire, std::memory_order::relaxed);
+    }
+
+    void unlock(Node&) noexcept {
+        m_serving.store(m_serving.load(std::memory_order::relaxed) + 1, std::memory_order::release);
+    }
+
+private:
+    std::atomic<uint32_t> m_next{0};
+    std::atomic<uint32_t> m_serving{0};
+};
+
+/// Raw MCS queue lock. Every waiter spins on a flag in its own queue node, instead of the shared lock word,
+/// so waiting generates no cache traffic regardless of the amount of waiters. Handoff is FIFO.
+class alignas(ASP_CACHE_LINE_SIZE) RawMcsLock {
+public:
+    /// Must stay at the same address while the lock is held or being acquired.
+    struct alignas(ASP_CACHE_LINE_SIZE) Node {
+        std::atomic<Node*> next{nullptr};
+        std::atomic<bool> locked{false};
+    };
+
+    void lock(Node& node) noexcept {
+        node.next.store(nullptr, std::memory_order::relaxed);
+        node.locked.store(true, std::memory_order::relaxed);
+
+        Node* prev = m_tail.exchange(&node, std::memory_order::acq_rel);
+        if (!prev) return;
+
+        // queue up behind the previous holder and wait for it to hand the lock over
+        prev->next.store(&node, std::memory_order::release);
+
+        Backoff backoff;
+        while (node.locked.load(std::memory_order::acquire)) {
+            backoff.snooze();
+        }
+    }
+
+    bool tryLock(Node& node) noexcept {
+        node.next.store(nullptr, std::memory_order::relaxed);
+
+        Node* expected = nullptr;
+        return m_tail.compare_exchange_strong(expected, &node, std::memory_order::acquire, std::memory_order::relaxed);
+    }
+
+    void unlock(Node& node) noexcept {
+        Node* next = node.next.load(std::memory_order::acquire);
+
+        if (!next) {
+            // no known successor, try to mark the lock as free
+            Node* expected = &node;
+            if (m_tail.compare_exchange_strong(expected, nullptr, std::memory_order::release, std::memory_order::relaxed)) {
+                return;
+            }
+
+            // somebody swapped the tail but hasn't linked themselves yet
+            while (!(next = node.next.load(std::memory_order::acquire))) {
+                cpuRelax();
+            }
+        }
+
+        next->locked.store(false, std::memory_order::release);
+    }
+
+private:
+    std::atomic<Node*> m_tail{nullptr};
+};
+
+/// A spinlock with FIFO fairness, built on top of a queued raw lock (`RawTicketLock` or `RawMcsLock`).
+/// Unlike `SpinLock`, waiters can't be starved, which matters for heavily contended locks with many threads.
+template <typename Inner, typename Raw>
+class FairSpinLock {
+    struct Empty {};
+    using Storage = std::conditional_t<std::is_void_v<Inner>, Empty, Inner>;
+
+public:
+    template <typename... Args>
+    FairSpinLock(Args&&... args) : data(std::forward<Args>(args)...) {}
+
+    FairSpinLock(const FairSpinLock&) = delete;
+    FairSpinLock(FairSpinLock&&) = delete;
+
+    FairSpinLock& operator=(const FairSpinLock&) = delete;
+    FairSpinLock& operator=(FairSpinLock&&) = delete;
+
+    /// The guard holds the queue node of the raw lock, so it can't be moved.
+    class [[nodiscard("A mutex guard must be stored in a variable to be effective")]] Guard {
+    public:
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        Guard(const FairSpinLock& mtx) noexcept : mtx(mtx) {
+            mtx.raw.lock(node);
+        }
+
+        inline ~Guard() noexcept {
+            this->unlock();
+        }
+
+        // Unlocks the mutex. Any access to this `Guard` afterwards invokes undefined behavior,
+        // unless it is relocked again with `.relock()`.
+        inline void unlock() noexcept {
+            if (!alreadyUnlocked) {
+                mtx.raw.unlock(node);
+                alreadyUnlocked = true;
+            }
+        }
+
+        // Relocks the mutex after being unlocked with `unlock()`.
+        // If the mutex was already locked, this does nothing.
+        inline void relock() noexcept {
+            if (alreadyUnlocked) {
+                mtx.raw.lock(node);
+                alreadyUnlocked = false;
+            }
+        }
+
+        template <typename U = Inner> requires (!std::is_void_v<U>)
+        U& operator*() {
+            return mtx.data;
+        }
+
+        template <typename U = Inner> requires (!std::is_void_v<U>)
+        const U& operator*() const {
+            return mtx.data;
+        }
+
+        template <typename U = Inner> requires (!std::is_void_v<U>)
+        U* operator->() {
+            return &mtx.data;
+        }
+
+        template <typename U = Inner> requires (!std::is_void_v<U>)
+        const U* operator->() const {
+            return &mtx.data;
+        }
+
+    private:
+        const FairSpinLock& mtx;
+        typename Raw::Node node{};
+        bool alreadyUnlocked = false;
+    };
+
+    Guard lock() const noexcept {
+        return Guard(*this);
+    }
+
+private:
+    friend class Guard;
+
+    mutable Raw raw;
+    mutable Storage data;
+};
+
+/// Fair spinlock that hands out tickets, waiters are served in arrival order. Cheap, but all waiters poll one cache line.
+template <typename Inner = void>
+using TicketSpinLock = FairSpinLock<Inner, RawTicketLock>;
+
+/// Fair spinlock where each waiter spins on its own queue node. Scales best when many threads contend for the lock.
+template <typename Inner = void>
+using McsSpinLock = FairSpinLock<Inner, RawMcsLock>;
+
+}
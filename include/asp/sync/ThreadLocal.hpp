@@ -0,0 +1,153 @@
+#pragma once
+#include "../detail/config.hpp"
+#include <asp/data/nums.hpp>
+
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <new>
+
+namespace asp {
+
+namespace detail {
+
+/// Returns an index that is unique among the currently running threads. Indices of exited threads are reused,
+/// smallest first, so they stay dense.
+usize threadLocalIndex() noexcept;
+
+}
+
+/// Per-object thread-local storage. Unlike a `thread_local` variable, every `ThreadLocal` object has its own set of values,
+/// and all of them can be visited with `forEach`, which makes it useful for per-thread statistics that are aggregated when read.
+///
+/// Values are created lazily, the first time a thread asks for one, and live until the `ThreadLocal` is destroyed or cleared.
+/// When a thread exits, its value is kept (so that it is still counted by `forEach`), and is handed to the next thread
+/// that is assigned the same index. Each value is on its own cache line, so threads never contend on each other's values.
+template <typename T>
+class ThreadLocal {
+public:
+    ThreadLocal() = default;
+
+    ThreadLocal(const ThreadLocal&) = delete;
+    ThreadLocal& operator=(const ThreadLocal&) = delete;
+    ThreadLocal(ThreadLocal&&) = delete;
+    ThreadLocal& operator=(ThreadLocal&&) = delete;
+
+    ~ThreadLocal() {
+        this->clear();
+
+        for (auto& bucket : m_buckets) {
+            delete[] bucket.load(std::memory_order::relaxed);
+        }
+    }
+
+    /// Returns the value of the calling thread, or `nullptr` if it has not been created yet.
+    T* get() noexcept {
+        auto entry = this->entry(detail::threadLocalIndex(), false);
+        return entry && entry->present.load(std::memory_order::relaxed) ? entry->ptr() : nullptr;
+    }
+
+    /// Returns the value of the calling thread, creating it with `f()` if it doesn't exist yet.
+    template <typename F>
+    T& getOrInit(F&& f) {
+        auto entry = this->entry(detail::threadLocalIndex(), true);
+
+        if (!entry->present.load(std::memory_order::relaxed)) [[unlikely]] {
+            std::construct_at(entry->ptr(), f());
+            entry->present.store(true, std::memory_order::release);
+        }
+
+        return *entry->ptr();
+    }
+
+    /// Returns the value of the calling thread, value-initializing it if it doesn't exist yet.
+    T& getOrDefault() {
+        auto entry = this->entry(detail::threadLocalIndex(), true);
+
+        if (!entry->present.load(std::memory_order::relaxed)) [[unlikely]] {
+            std::construct_at(entry->ptr());
+            entry->present.store(true, std::memory_order::release);
+        }
+
+        return *entry->ptr();
+    }
+
+    /// Calls `f` with the value of every thread that has one, including threads that have already exited.
+    /// This can run concurrently with other threads creating their values (which may or may not be visited),
+    /// but the values themselves are not locked, so `T` should be safe to read while its owner modifies it (e.g. an atomic).
+    template <typename F>
+    void forEach(F&& f) {
+        this->visit([&](Entry& entry) { f(*entry.ptr()); });
+    }
+
+    template <typename F>
+    void forEach(F&& f) const {
+        const_cast<ThreadLocal*>(this)->visit([&](Entry& entry) { f(static_cast<const T&>(*entry.ptr())); });
+    }
+
+    /// Destroys all values. Must not be called concurrently with any other method.
+    void clear() noexcept {
+        this->visit([](Entry& entry) {
+            std::destroy_at(entry.ptr());
+            entry.present.store(false, std::memory_order::relaxed);
+        });
+    }
+
+private:
+    struct alignas(ASP_CACHE_LINE_SIZE) Entry {
+        // only ever set by the owning thread, so it can read it relaxed
+        std::atomic<bool> present{false};
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* ptr() noexcept {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    // bucket `i` holds `2^i` entries, so they never have to be moved when the thread count grows
+    static constexpr usize BUCKETS = sizeof(usize) * 8;
+    std::atomic<Entry*> m_buckets[BUCKETS] = {};
+
+    Entry* entry(usize index, bool create) {
+        usize pos = index + 1;
+        usize bucket = std::bit_width(pos) - 1;
+        usize offset = pos - ((usize)1 << bucket);
+
+        Entry* entries = m_buckets[bucket].load(std::memory_order::acquire);
+
+        if (!entries) [[unlikely]] {
+            if (!create) return nullptr;
+            entries = this->allocateBucket(bucket);
+        }
+
+        return &entries[offset];
+    }
+
+    ASP_NOINLINE Entry* allocateBucket(usize bucket) {
+        Entry* entries = new Entry[(usize)1 << bucket];
+        Entry* expected = nullptr;
+
+        if (!m_buckets[bucket].compare_exchange_strong(expected, entries, std::memory_order::acq_rel, std::memory_order::acquire)) {
+            delete[] entries;
+            return expected;
+        }
+
+        return entries;
+    }
+
+    template <typename F>
+    void visit(F&& f) {
+        for (usize i = 0; i < BUCKETS; i++) {
+            Entry* entries = m_buckets[i].load(std::memory_order::acquire);
+            if (!entries) continue;
+
+            for (usize j = 0; j < ((usize)1 << i); j++) {
+                if (entries[j].present.load(std::memory_order::acquire)) {
+                    f(entries[j]);
+                }
+            }
+        }
+    }
+};
+
+}
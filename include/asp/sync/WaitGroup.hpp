@@ -0,0 +1,101 @@
+#pragma once
+#include "../detail/config.hpp"
+#include <asp/data/nums.hpp>
+#include <asp/time/Duration.hpp>
+#include <asp/time/Instant.hpp>
+#include <atomic>
+
+namespace asp {
+
+/// Waits for a dynamic set of tasks to finish. Call `add` before starting a task and `done` when it finishes,
+/// `wait` blocks until the amount of unfinished tasks reaches zero.
+/// Unlike a `Latch`, a wait group can be reused, tasks can be added again after it reached zero.
+class WaitGroup {
+public:
+    WaitGroup(u32 count = 0) : m_state(count) {}
+
+    WaitGroup(const WaitGroup&) = delete;
+    WaitGroup& operator=(const WaitGroup&) = delete;
+    WaitGroup(WaitGroup&&) = delete;
+    WaitGroup& operator=(WaitGroup&&) = delete;
+
+    /// Registers `count` new unfinished tasks.
+    void add(u32 count = 1) noexcept {
+        m_state.fetch_add(count, std::memory_order::relaxed);
+    }
+
+    /// Marks `count` tasks as finished, waking up all waiters if none are left.
+    void done(u32 count = 1) noexcept {
+        u32 prev = m_state.fetch_sub(count, std::memory_order::acq_rel);
+
+        ASP_ASSERT((prev & COUNT_MASK) >= count, "WaitGroup::done called more times than add");
+
+        if ((prev & COUNT_MASK) == count && (prev & WAITING)) [[unlikely]] {
+            this->wakeAll();
+        }
+    }
+
+    /// Returns the amount of unfinished tasks.
+    u32 count() const noexcept {
+        return m_state.load(std::memory_order::acquire) & COUNT_MASK;
+    }
+
+    /// Blocks until all tasks are finished.
+    void wait() const noexcept {
+        this->waitUntil(Instant::farFuture());
+    }
+
+    /// Blocks until all tasks are finished or the timeout expires. Returns false if the timeout expired.
+    bool wait(const time::Duration& timeout) const noexcept {
+        return this->count() == 0 || this->waitUntil(Instant::now() + timeout);
+    }
+
+    /// Blocks until all tasks are finished or the deadline is reached. Returns false if the deadline was reached.
+    bool waitUntil(const time::Instant& deadline) const noexcept;
+
+private:
+    // the highest bit is set while somebody is sleeping, the rest is the task count
+    static constexpr u32 WAITING = 1u << 31;
+    static constexpr u32 COUNT_MASK = WAITING - 1;
+
+    mutable std::atomic<u32> m_state;
+
+    ASP_COLD void wakeAll() noexcept;
+};
+
+/// A single-use countdown. Threads block in `wait` until `countDown` was called the amount of times given in the constructor.
+class Latch {
+public:
+    Latch(u32 count) : m_group(count) {}
+
+    /// Decrements the counter by `n`, releasing all waiters once it reaches zero.
+    void countDown(u32 n = 1) noexcept {
+        m_group.done(n);
+    }
+
+    /// Decrements the counter by one and waits for it to reach zero.
+    void arriveAndWait() noexcept {
+        m_group.done();
+        m_group.wait();
+    }
+
+    /// Returns true if the counter has reached zero.
+    bool tryWait() const noexcept {
+        return m_group.count() == 0;
+    }
+
+    /// Blocks until the counter reaches zero.
+    void wait() const noexcept {
+        m_group.wait();
+    }
+
+    /// Blocks until the counter reaches zero or the timeout expires. Returns false if the timeout expired.
+    bool wait(const time::Duration& timeout) const noexcept {
+        return m_group.wait(timeout);
+    }
+
+private:
+    WaitGroup m_group;
+};
+
+}
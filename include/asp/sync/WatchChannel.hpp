@@ -0,0 +1,153 @@
+#pragma once
+#include <asp/ptr/PtrSwap.hpp>
+#include <asp/time/Duration.hpp>
+#include <asp/time/chrono.hpp>
+#include <asp/data/nums.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace asp {
+
+/// Single-value broadcast channel, where receivers only ever observe the latest published value.
+/// Every `send` replaces the current value and bumps the version, which receivers can use to cheaply check for changes.
+template <typename T>
+class WatchChannel {
+public:
+    using Ptr = SharedPtr<T>;
+
+    /// Handle that keeps track of the last version it has seen.
+    class Receiver {
+    public:
+        Receiver(const WatchChannel& channel) : m_channel(&channel), m_seen(channel.version()) {}
+
+        Receiver(const Receiver&) = default;
+        Receiver& operator=(const Receiver&) = default;
+
+        /// Returns whether a new value was published since the last time this receiver marked a value as seen.
+        bool changed() const noexcept {
+            return m_channel->version() != m_seen;
+        }
+
+        /// Returns the current value without marking it as seen.
+        Ptr borrow() const {
+            return m_channel->load();
+        }
+
+        /// Returns the current value and marks it as seen.
+        /// A concurrent `send` may be returned here while only the version before it is marked as seen, so the same value can be returned twice.
+        Ptr borrowAndUpdate() {
+            // load the version first, so that a concurrent send is never marked as seen without being observed
+            m_seen = m_channel->version();
+            return m_channel->load();
+        }
+
+        /// Marks the current value as seen, without loading it.
+        void markSeen() noexcept {
+            m_seen = m_channel->version();
+        }
+
+        /// Blocks until a value newer than the last seen one is published, then marks it as seen and returns it.
+        /// No update is ever missed, but the returned value may be the same one that the previous call returned (see `borrowAndUpdate`).
+        Ptr waitForChange() {
+            m_channel->waitForVersion(m_seen, time::Duration::infinite());
+            return this->borrowAndUpdate();
+        }
+
+        /// Like `waitForChange`, but returns a null pointer if the timeout expires before a new value is published.
+        Ptr waitForChange(const time::Duration& timeout) {
+            if (!m_channel->waitForVersion(m_seen, timeout)) {
+                return nullptr;
+            }
+
+            return this->borrowAndUpdate();
+        }
+
+    private:
+        const WatchChannel* m_channel;
+        u64 m_seen;
+    };
+
+    WatchChannel() {}
+    WatchChannel(Ptr initial) : m_value(std::move(initial)) {}
+
+    WatchChannel(const WatchChannel&) = delete;
+    WatchChannel& operator=(const WatchChannel&) = delete;
+    WatchChannel(WatchChannel&&) = delete;
+    WatchChannel& operator=(WatchChannel&&) = delete;
+
+    /// Creates a new receiver, which considers the current value as already seen.
+    Receiver subscribe() const {
+        return Receiver(*this);
+    }
+
+    /// Returns the current value. This does not lock.
+    Ptr load() const {
+        return m_value.load();
+    }
+
+    /// Returns the current version. It starts at 0 and is incremented by every `send`.
+    u64 version() const noexcept {
+        return m_version.load(std::memory_order::acquire);
+    }
+
+    /// Publishes a new value and wakes up all receivers waiting for a change.
+    void send(Ptr value) {
+        m_value.store(std::move(value));
+        this->bumpVersion();
+    }
+
+    /// Publishes a new value and wakes up all receivers waiting for a change.
+    void send(T value) {
+        this->send(asp::make_shared<T>(std::move(value)));
+    }
+
+    /// Publishes a new value, returning the previous one.
+    Ptr replace(Ptr value) {
+        Ptr old = m_value.swap(std::move(value));
+        this->bumpVersion();
+        return old;
+    }
+
+private:
+    PtrSwap<T> m_value;
+    std::atomic<u64> m_version{0};
+    mutable std::atomic<u32> m_waiters{0};
+    mutable std::mutex m_mtx;
+    mutable std::condition_variable m_cvar;
+
+    void bumpVersion() {
+        m_version.fetch_add(1, std::memory_order::seq_cst);
+
+        // only touch the mutex if someone is actually blocked
+        if (m_waiters.load(std::memory_order::seq_cst) != 0) {
+            std::unique_lock lock(m_mtx);
+            m_cvar.notify_all();
+        }
+    }
+
+    bool waitForVersion(u64 seen, const time::Duration& timeout) const {
+        if (this->version() != seen) {
+            return true;
+        }
+
+        m_waiters.fetch_add(1, std::memory_order::seq_cst);
+
+        std::unique_lock lock(m_mtx);
+        auto pred = [&] { return this->version() != seen; };
+
+        bool result;
+        if (timeout == time::Duration::infinite()) {
+            m_cvar.wait(lock, pred);
+            result = true;
+        } else {
+            result = m_cvar.wait_for(lock, time::toChrono<std::chrono::microseconds>(timeout), pred);
+        }
+
+        m_waiters.fetch_sub(1, std::memory_order::relaxed);
+        return result;
+    }
+};
+
+}
@@ -2,6 +2,7 @@
 
 #include "../detail/config.hpp"
 #include "../detail/Function.hpp"
+#include "../sync/Epoch.hpp"
 #include "../Log.hpp"
 
 #include <memory>
@@ -14,6 +15,15 @@ namespace asp {
 
 void _setThreadName(const std::string& name);
 
+/// Returns the index of the CPU core the calling thread is running on. The thread may migrate at any moment,
+/// so this is only a hint, useful for picking a shard to reduce contention.
+/// On platforms where this can't be queried cheaply, returns a stable per-thread index instead.
+unsigned int currentCpu() noexcept;
+
+/// Returns the amount of shards to use for a per-CPU table indexed by `currentCpu() & (count - 1)`.
+/// This is the CPU count rounded up to a power of two, capped at 64.
+unsigned int cpuShardCount() noexcept;
+
 template <typename... TFuncArgs>
 class Thread {
 public:
@@ -82,6 +92,7 @@ public:
 
         _handle = std::thread([_storage = _storage](TFuncArgs&&... args) {
             ::asp::_setThreadName(_storage->name);
+            ::asp::epoch::registerThread();
 
             if (_storage->onStart) {
                 _storage->onStart();
@@ -106,6 +117,8 @@ public:
                 _storage->onTermination();
             }
 
+            ::asp::epoch::unregisterThread();
+
             _storage->_stopped.test_and_set();
         }, std::forward<TFuncArgs>(args)...);
     }
@@ -122,6 +135,7 @@ public:
 
         _handle = std::thread([_storage = _storage](TFuncArgs&&... args) {
             ::asp::_setThreadName(_storage->name);
+            ::asp::epoch::registerThread();
 
             if (_storage->onStart) {
                 _storage->onStart();
@@ -146,6 +160,8 @@ public:
                 _storage->onTermination();
             }
 
+            ::asp::epoch::unregisterThread();
+
             _storage->_stopped.test_and_set();
         }, args...);
     }
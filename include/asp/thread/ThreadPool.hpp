@@ -2,9 +2,8 @@
 
 #include "Thread.hpp"
 #include "../sync/Channel.hpp"
+#include "../sync/WaitGroup.hpp"
 #include <asp/detail/Function.hpp>
-#include <atomic>
-#include <semaphore>
 
 namespace asp {
 
@@ -52,9 +51,7 @@ private:
     struct Storage {
         std::vector<Worker> workers;
         Channel<Task> taskQueue;
-        std::atomic<size_t> remainingWork{0};
-        std::atomic<bool> notifyWaiter{false};
-        std::binary_semaphore waiterSem{0};
+        WaitGroup remainingWork;
         asp::CopyableFunction<void(const std::exception&)> onException;
     };
 
@@ -0,0 +1,127 @@
+#include <asp/sync/Futex.hpp>
+
+#if defined(__linux__)
+# include <linux/futex.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+# include <time.h>
+# include <errno.h>
+# include <limits.h>
+#elif defined(__APPLE__)
+# include <errno.h>
+
+// Private, but stable API that libc++ also uses to implement std::atomic::wait
+extern "C" int __ulock_wait(uint32_t operation, void* addr, uint64_t value, uint32_t timeout);
+extern "C" int __ulock_wake(uint32_t operation, void* addr, uint64_t wakeValue);
+
+# define UL_COMPARE_AND_WAIT 1
+# define ULF_WAKE_ALL 0x00000100
+# define ULF_NO_ERRNO 0x01000000
+#else
+# include <condition_variable>
+# include <mutex>
+# include <chrono>
+#endif
+
+namespace asp::futex {
+
+#if defined(__linux__)
+
+static long sysFutex(const std::atomic<u32>& word, int op, u32 val, const timespec* ts) {
+    return syscall(SYS_futex, (u32*)&word, op | FUTEX_PRIVATE_FLAG, val, ts, nullptr, 0);
+}
+
+bool wait(const std::atomic<u32>& word, u32 expected, const time::Duration& timeout) {
+    timespec ts;
+    timespec* tsp = nullptr;
+
+    if (timeout != time::Duration::infinite()) {
+        ts.tv_sec = (time_t)timeout.seconds();
+        ts.tv_nsec = (long)timeout.subsecNanos();
+        tsp = &ts;
+    }
+
+    if (sysFutex(word, FUTEX_WAIT, expected, tsp) == -1 && errno == ETIMEDOUT) {
+        return false;
+    }
+
+    // woken up, value mismatch (EAGAIN) or interrupted (EINTR)
+    return true;
+}
+
+bool wakeOne(const std::atomic<u32>& word) {
+    return sysFutex(word, FUTEX_WAKE, 1, nullptr) > 0;
+}
+
+void wakeAll(const std::atomic<u32>& word) {
+    sysFutex(word, FUTEX_WAKE, INT_MAX, nullptr);
+}
+
+#elif defined(__APPLE__)
+
+bool wait(const std::atomic<u32>& word, u32 expected, const time::Duration& timeout) {
+    // 0 means no timeout, clamp long timeouts
+    uint32_t micros = 0;
+    if (timeout != time::Duration::infinite()) {
+        u64 m = timeout.micros();
+        micros = m == 0 ? 1 : (m > UINT32_MAX ? UINT32_MAX : (uint32_t)m);
+    }
+
+    int rc = __ulock_wait(UL_COMPARE_AND_WAIT | ULF_NO_ERRNO, (void*)&word, expected, micros);
+    return rc != -ETIMEDOUT;
+}
+
+bool wakeOne(const std::atomic<u32>& word) {
+    // returns -ENOENT if nobody was waiting
+    return __ulock_wake(UL_COMPARE_AND_WAIT | ULF_NO_ERRNO, (void*)&word, 0) == 0;
+}
+
+void wakeAll(const std::atomic<u32>& word) {
+    __ulock_wake(UL_COMPARE_AND_WAIT | ULF_WAKE_ALL | ULF_NO_ERRNO, (void*)&word, 0);
+}
+
+#else
+
+// Generic fallback, a small table of condition variables keyed by the address of the word
+
+struct Bucket {
+    std::mutex mtx;
+    std::condition_variable cvar;
+};
+
+static Bucket& bucketFor(const void* addr) {
+    static Bucket buckets[64];
+    return buckets[((uintptr_t)addr >> 4) % 64];
+}
+
+bool wait(const std::atomic<u32>& word, u32 expected, const time::Duration& timeout) {
+    auto& bucket = bucketFor(&word);
+    std::unique_lock lock(bucket.mtx);
+
+    if (word.load(std::memory_order::relaxed) != expected) {
+        return true;
+    }
+
+    if (timeout == time::Duration::infinite()) {
+        bucket.cvar.wait(lock);
+        return true;
+    }
+
+    return bucket.cvar.wait_for(lock, std::chrono::nanoseconds(timeout.nanos())) == std::cv_status::no_timeout;
+}
+
+bool wakeOne(const std::atomic<u32>& word) {
+    // other words may share the bucket, so everyone has to be woken up
+    wakeAll(word);
+    return false;
+}
+
+void wakeAll(const std::atomic<u32>& word) {
+    auto& bucket = bucketFor(&word);
+    std::unique_lock lock(bucket.mtx);
+    bucket.cvar.notify_all();
+}
+
+#endif
+
+}
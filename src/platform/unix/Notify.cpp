@@ -1,102 +1,111 @@
 #include <asp/sync/Notify.hpp>
-#include <asp/time/SystemTime.hpp>
-#include <asp/Log.hpp>
+#include <asp/time/Instant.hpp>
+#include <algorithm>
 #include <stdexcept>
+#include <string>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+# include <sys/eventfd.h>
+#endif
 
 namespace asp {
 
-pthread_mutex_t* Notify::_mutex() {
-    return &_mutexStorage;
-}
+PollableNotify::PollableNotify() {
+#if defined(__linux__)
+    m_readFd = m_writeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_readFd == -1) {
+        throw std::runtime_error(std::string("eventfd failed: ") + std::strerror(errno));
+    }
+#else
+    int fds[2];
+    if (pipe(fds) != 0) {
+        throw std::runtime_error(std::string("pipe failed: ") + std::strerror(errno));
+    }
 
-pthread_cond_t* Notify::_cond() {
-    return &_condStorage;
-}
+    for (int fd : fds) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
 
-Notify::Notify() {
-    pthread_mutex_init(_mutex(), nullptr);
-    pthread_cond_init(_cond(), nullptr);
+    m_readFd = fds[0];
+    m_writeFd = fds[1];
+#endif
 }
 
-Notify::~Notify() {
-    pthread_mutex_destroy(_mutex());
-    pthread_cond_destroy(_cond());
+PollableNotify::~PollableNotify() {
+    close(m_readFd);
+    if (m_writeFd != m_readFd) {
+        close(m_writeFd);
+    }
 }
 
-void Notify::wait() {
-    pthread_mutex_lock(_mutex());
-    pthread_cond_wait(_cond(), _mutex());
-    pthread_mutex_unlock(_mutex());
+void PollableNotify::notify() {
+#if defined(__linux__)
+    u64 one = 1;
+    (void) ::write(m_writeFd, &one, sizeof(one));
+#else
+    // if the pipe is full, there is a permit stored already
+    char one = 1;
+    (void) ::write(m_writeFd, &one, 1);
+#endif
 }
 
-bool Notify::wait(const time::Duration& timeout) {
-    // note: we rely on the fact that SystemTime also uses CLOCK_REALTIME
-
-    auto expiry = time::SystemTime::now() + timeout;
-    auto dur = expiry.timeSinceEpoch();
-
-    struct timespec ts;
-    ts.tv_sec = dur.seconds();
-    ts.tv_nsec = dur.subsecNanos();
-
-    pthread_mutex_lock(_mutex());
-    int result = pthread_cond_timedwait(_cond(), _mutex(), &ts);
-    pthread_mutex_unlock(_mutex());
-
-    if (result != 0 && result != ETIMEDOUT) {
-        // If the error is not ETIMEDOUT, we throw an exception
-        asp::log(LogLevel::Error, "pthread_cond_timedwait failed with error: " + std::to_string(result));
-        throw std::runtime_error("pthread_cond_timedwait failed");
+bool PollableNotify::consume() {
+#if defined(__linux__)
+    // reading an eventfd resets the counter, so multiple notifications are coalesced
+    u64 count;
+    return ::read(m_readFd, &count, sizeof(count)) == sizeof(count);
+#else
+    char buf[64];
+    bool any = false;
+
+    while (::read(m_readFd, buf, sizeof(buf)) > 0) {
+        any = true;
     }
 
-    return result == 0;
+    return any;
+#endif
 }
 
-bool Notify::wait(const time::Duration& timeout, asp::FunctionRef<bool()> predicate) {
-    pthread_mutex_lock(_mutex());
+void PollableNotify::wait() {
+    this->wait(time::Duration::infinite());
+}
 
-    if (timeout.isZero()) {
-        // If timeout is zero, we wait indefinitely
-        while (!predicate()) {
-            pthread_cond_wait(_cond(), _mutex());
-        }
+bool PollableNotify::wait(const time::Duration& timeout) {
+    auto deadline = Instant::now() + timeout;
 
-        pthread_mutex_unlock(_mutex());
-        return true;
-    }
+    while (!this->consume()) {
+        int ms = -1;
 
-    auto expiry = time::SystemTime::now() + timeout;
-    auto dur = expiry.timeSinceEpoch();
+        if (deadline != Instant::farFuture()) {
+            auto left = deadline.until();
+            if (left.isZero()) {
+                return false;
+            }
 
-    struct timespec ts;
-    ts.tv_sec = dur.seconds();
-    ts.tv_nsec = dur.subsecNanos();
+            // round up, so we never wake up before the deadline
+            ms = (int)std::min<u64>(left.millis<u64>() + (left.subsecNanos() % 1'000'000 != 0), INT32_MAX);
+        }
 
-    while (!predicate()) {
-        int result = pthread_cond_timedwait(_cond(), _mutex(), &ts);
+        struct pollfd pfd = {m_readFd, POLLIN, 0};
+        int rc = ::poll(&pfd, 1, ms);
 
-        if (result == ETIMEDOUT) {
-            pthread_mutex_unlock(_mutex());
-            return false;
-        } else if (result != 0) {
-            pthread_mutex_unlock(_mutex());
-            asp::log(LogLevel::Error, "pthread_cond_timedwait failed with error: " + std::to_string(result));
-            throw std::runtime_error("pthread_cond_timedwait failed");
+        if (rc < 0 && errno != EINTR) {
+            throw std::runtime_error(std::string("poll failed: ") + std::strerror(errno));
         }
-
-        // keep checking the predicate
     }
 
-    pthread_mutex_unlock(_mutex());
     return true;
 }
 
-void Notify::notifyOne() {
-    pthread_cond_signal(_cond());
+PollableNotify::NativeHandle PollableNotify::nativeHandle() const noexcept {
+    return m_readFd;
 }
 
-void Notify::notifyAll() {
-    pthread_cond_broadcast(_cond());
 }
-
-}
\ No newline at end of file
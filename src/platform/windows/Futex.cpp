@@ -0,0 +1,36 @@
+#include <asp/sync/Futex.hpp>
+
+#ifndef WIN32_LEAN_AND_MEAN
+# define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+
+#pragma comment(lib, "Synchronization.lib")
+
+namespace asp::futex {
+
+bool wait(const std::atomic<u32>& word, u32 expected, const time::Duration& timeout) {
+    DWORD millis = INFINITE;
+    if (timeout != time::Duration::infinite()) {
+        // round up, so that we never wake up before the timeout expires
+        u64 ms = (timeout.nanos() + 999'999) / 1'000'000;
+        millis = ms >= INFINITE ? INFINITE - 1 : (DWORD)ms;
+    }
+
+    if (!WaitOnAddress((volatile void*)&word, &expected, sizeof(u32), millis)) {
+        return GetLastError() != ERROR_TIMEOUT;
+    }
+
+    return true;
+}
+
+bool wakeOne(const std::atomic<u32>& word) {
+    WakeByAddressSingle((void*)&word);
+    return false;
+}
+
+void wakeAll(const std::atomic<u32>& word) {
+    WakeByAddressAll((void*)&word);
+}
+
+}
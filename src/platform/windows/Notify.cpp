@@ -1,5 +1,7 @@
 #include <asp/sync/Notify.hpp>
 #include <asp/time/Instant.hpp>
+#include <algorithm>
+#include <stdexcept>
 
 #ifndef WIN32_LEAN_AND_MEAN
 # define WIN32_LEAN_AND_MEAN
@@ -8,78 +10,57 @@
 
 namespace asp {
 
-CRITICAL_SECTION* Notify::_crit() {
-    static_assert(sizeof(_critStorage) == sizeof(CRITICAL_SECTION));
-    return (CRITICAL_SECTION*)&_critStorage[0];
-}
-
-CONDITION_VARIABLE* Notify::_cond() {
-    static_assert(sizeof(_condStorage) == sizeof(CONDITION_VARIABLE));
-    return (CONDITION_VARIABLE*)&_condStorage[0];
+PollableNotify::PollableNotify() {
+    // auto-reset, so a successful wait consumes the permit
+    m_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!m_event) {
+        throw std::runtime_error("CreateEventW failed");
+    }
 }
 
-Notify::Notify() {
-    InitializeCriticalSection(_crit());
-    InitializeConditionVariable(_cond());
+PollableNotify::~PollableNotify() {
+    CloseHandle(m_event);
 }
 
-Notify::~Notify() {
-    DeleteCriticalSection(_crit());
-    // CONDITION_VARIABLE does not need explicit deletion
+void PollableNotify::notify() {
+    SetEvent(m_event);
 }
 
-void Notify::wait() {
-    EnterCriticalSection(_crit());
-    SleepConditionVariableCS(_cond(), _crit(), INFINITE);
-    LeaveCriticalSection(_crit());
+bool PollableNotify::consume() {
+    return WaitForSingleObject(m_event, 0) == WAIT_OBJECT_0;
 }
 
-bool Notify::wait(const time::Duration& timeout) {
-    EnterCriticalSection(_crit());
-    bool result = SleepConditionVariableCS(_cond(), _crit(), timeout.millis<u64>());
-    LeaveCriticalSection(_crit());
-    return result;
+void PollableNotify::wait() {
+    WaitForSingleObject(m_event, INFINITE);
 }
 
-bool Notify::wait(const time::Duration& timeout, asp::FunctionRef<bool()> predicate) {
-    EnterCriticalSection(_crit());
-
-    if (timeout.isZero()) {
-        // If timeout is zero, we wait indefinitely
-        while (!predicate()) {
-            SleepConditionVariableCS(_cond(), _crit(), INFINITE);
-        }
-
-        LeaveCriticalSection(_crit());
+bool PollableNotify::wait(const time::Duration& timeout) {
+    if (timeout == time::Duration::infinite()) {
+        this->wait();
         return true;
     }
 
-    auto begin = time::Instant::now();
+    auto deadline = Instant::now() + timeout;
 
-    while (!predicate()) {
-        auto leftTime = timeout - begin.elapsed();
-        if (leftTime.isZero()) {
-            // If we have no time left, we exit the loop
-            LeaveCriticalSection(_crit());
-            return false;
-        }
+    while (true) {
+        auto left = deadline.until();
+
+        // round up, so we never wake up before the deadline
+        DWORD ms = (DWORD)std::min<u64>(left.millis<u64>() + (left.subsecNanos() % 1'000'000 != 0), INFINITE - 1);
 
-        if (!SleepConditionVariableCS(_cond(), _crit(), leftTime.millis<u64>())) {
-            LeaveCriticalSection(_crit());
+        DWORD rc = WaitForSingleObject(m_event, ms);
+        if (rc == WAIT_OBJECT_0) {
+            return true;
+        } else if (rc != WAIT_TIMEOUT) {
+            throw std::runtime_error("WaitForSingleObject failed");
+        } else if (left.isZero()) {
             return false;
         }
     }
-
-    LeaveCriticalSection(_crit());
-    return true;
 }
 
-void Notify::notifyOne() {
-    WakeConditionVariable(_cond());
+PollableNotify::NativeHandle PollableNotify::nativeHandle() const noexcept {
+    return m_event;
 }
 
-void Notify::notifyAll() {
-    WakeAllConditionVariable(_cond());
 }
-
-}
\ No newline at end of file
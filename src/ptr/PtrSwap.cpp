@@ -0,0 +1,69 @@
+#include <asp/ptr/PtrSwap.hpp>
+
+namespace asp::detail {
+
+struct DebtNode {
+    DebtSlots slots{};
+    std::atomic<bool> inUse{true};
+    DebtNode* next = nullptr;
+};
+
+// nodes are never freed, the nodes of exited threads are reused by new ones.
+// a guard can outlive its thread, a reused node simply sees that slot as taken until the guard is dropped
+static std::atomic<DebtNode*> g_nodes{nullptr};
+
+static DebtNode* acquireNode() {
+    for (auto node = g_nodes.load(std::memory_order::acquire); node; node = node->next) {
+        bool expected = false;
+        if (!node->inUse.load(std::memory_order::relaxed) && node->inUse.compare_exchange_strong(expected, true, std::memory_order::acquire)) {
+            return node;
+        }
+    }
+
+    auto node = new DebtNode;
+
+    auto head = g_nodes.load(std::memory_order::relaxed);
+    do {
+        node->next = head;
+    } while (!g_nodes.compare_exchange_weak(head, node, std::memory_order::release, std::memory_order::relaxed));
+
+    return node;
+}
+
+struct LocalNode {
+    DebtNode* node = acquireNode();
+
+    ~LocalNode() {
+        node->inUse.store(false, std::memory_order::release);
+    }
+};
+
+DebtSlots& localDebtSlots() noexcept {
+    static thread_local LocalNode local;
+    return local.node->slots;
+}
+
+static void payDebt(std::atomic<size_t>& slot, size_t raw, void(*retain)(size_t), void(*unretain)(size_t)) noexcept {
+    if (slot.load(std::memory_order::seq_cst) != raw) return;
+
+    // the caller holds a reference, so the count can't drop to zero here
+    retain(raw);
+
+    size_t expected = raw;
+    if (!slot.compare_exchange_strong(expected, 0, std::memory_order::seq_cst)) {
+        // the reader dropped its debt by itself
+        unretain(raw);
+    }
+}
+
+void payDebts(size_t raw, void(*retain)(size_t), void(*unretain)(size_t)) noexcept {
+    for (auto node = g_nodes.load(std::memory_order::acquire); node; node = node->next) {
+        for (auto& slot : node->slots.fast) {
+            payDebt(slot, raw, retain, unretain);
+        }
+
+        payDebt(node->slots.fallback, raw, retain, unretain);
+    }
+}
+
+}
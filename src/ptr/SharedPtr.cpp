@@ -0,0 +1,270 @@
+#include <asp/ptr/SharedPtr.hpp>
+#include <asp/sync/RawMutex.hpp>
+#include <mutex>
+
+namespace asp::detail {
+
+struct BiasedOwner {
+    RawMutex mtx;
+    // whether a live thread owns this record, otherwise queued blocks are merged right away, under the lock
+    bool alive = true;
+    SharedPtrBlockBase* queue = nullptr;
+    std::atomic<bool> pending{false};
+    BiasedOwner* next = nullptr;
+};
+
+// records are never freed, the records of exited threads are reused by new ones, along with the blocks that are still biased towards them.
+// the lock makes the handoff safe, while a record is not alive its biased counts are only touched under the lock
+static std::atomic<BiasedOwner*> g_owners{nullptr};
+
+static BiasedOwner* acquireOwner() {
+    for (auto owner = g_owners.load(std::memory_order::acquire); owner; owner = owner->next) {
+        std::lock_guard lock{owner->mtx};
+
+        if (!owner->alive) {
+            owner->alive = true;
+            return owner;
+        }
+    }
+
+    auto owner = new BiasedOwner;
+
+    auto head = g_owners.load(std::memory_order::relaxed);
+    do {
+        owner->next = head;
+    } while (!g_owners.compare_exchange_weak(head, owner, std::memory_order::release, std::memory_order::relaxed));
+
+    return owner;
+}
+
+static void releaseWeak(SharedPtrBlockBase* block) noexcept {
+    if (block->weak.fetch_sub(1, std::memory_order::release) == 1) {
+        std::atomic_thread_fence(std::memory_order::acquire);
+        block->ops->deallocate(block);
+    }
+}
+
+static void destroyBlock(SharedPtrBlockBase* block) noexcept {
+    block->ops->destroy(block);
+    releaseWeak(block);
+}
+
+// gives up the bias by moving the owner's count into `strong`. Must be called by the owner, or under the lock of an exited owner.
+// returns true if the total count is zero
+static bool merge(SharedPtrBlockBase* block) noexcept {
+    auto state = SharedPtrBiasedState::of(block);
+    if (!state->owner.load(std::memory_order::relaxed)) return false;
+
+    size_t biased = state->biased.load(std::memory_order::relaxed);
+    state->biased.store(0, std::memory_order::relaxed);
+    state->owner.store(nullptr, std::memory_order::relaxed);
+
+    size_t add = biased * SharedPtrBiasedState::ONE + SharedPtrBiasedState::MERGED;
+    size_t old = block->strong.fetch_add(add, std::memory_order::acq_rel);
+
+    return SharedPtrBiasedState::count(old) + static_cast<ptrdiff_t>(biased) == 0;
+}
+
+// merges every block in the list and drops the weak references held by the queue
+static void mergeQueued(SharedPtrBlockBase* block) noexcept {
+    while (block) {
+        auto next = std::exchange(SharedPtrBiasedState::of(block)->nextQueued, nullptr);
+
+        if (merge(block)) {
+            destroyBlock(block);
+        }
+
+        releaseWeak(block);
+        block = next;
+    }
+}
+
+static void enqueue(SharedPtrBlockBase* block) noexcept {
+    auto state = SharedPtrBiasedState::of(block);
+    auto owner = state->owner.load(std::memory_order::relaxed);
+    if (!owner) return;
+
+    // the queue holds a weak reference, the block may be merged and destroyed by the owner before it gets to it
+    block->weak.fetch_add(1, std::memory_order::relaxed);
+
+    std::unique_lock lock{owner->mtx};
+
+    if (owner->alive) {
+        state->nextQueued = owner->queue;
+        owner->queue = block;
+        owner->pending.store(true, std::memory_order::release);
+        return;
+    }
+
+    // nobody is going to process the queue, merge right away
+    bool dead = merge(block);
+    lock.unlock();
+
+    if (dead) {
+        destroyBlock(block);
+    }
+
+    releaseWeak(block);
+}
+
+static thread_local bool t_exited = false;
+
+struct LocalOwner {
+    BiasedOwner* owner = acquireOwner();
+
+    LocalOwner() {
+        t_biasedOwner = owner;
+    }
+
+    ~LocalOwner() {
+        // from now on, this thread releases its references like any other thread
+        t_biasedOwner = nullptr;
+        t_exited = true;
+
+        SharedPtrBlockBase* dead = nullptr;
+        SharedPtrBlockBase* alive = nullptr;
+
+        {
+            std::lock_guard lock{owner->mtx};
+            auto queue = std::exchange(owner->queue, nullptr);
+            owner->pending.store(false, std::memory_order::relaxed);
+            owner->alive = false;
+
+            // the objects are destroyed once the lock is released, as their destructors may release other blocks owned by us
+            while (queue) {
+                auto state = SharedPtrBiasedState::of(queue);
+                auto next = state->nextQueued;
+
+                auto& list = merge(queue) ? dead : alive;
+                state->nextQueued = list;
+                list = queue;
+
+                queue = next;
+            }
+        }
+
+        while (dead) {
+            auto next = std::exchange(SharedPtrBiasedState::of(dead)->nextQueued, nullptr);
+            destroyBlock(dead);
+            releaseWeak(dead);
+            dead = next;
+        }
+
+        while (alive) {
+            auto next = std::exchange(SharedPtrBiasedState::of(alive)->nextQueued, nullptr);
+            releaseWeak(alive);
+            alive = next;
+        }
+    }
+};
+
+BiasedOwner* localBiasedOwner() noexcept {
+    if (t_exited) return nullptr;
+
+    static thread_local LocalOwner local;
+    drainBiasedQueue();
+
+    return local.owner;
+}
+
+void drainBiasedQueue() noexcept {
+    auto owner = t_biasedOwner;
+    if (!owner || !owner->pending.load(std::memory_order::acquire)) return;
+
+    SharedPtrBlockBase* queue;
+    {
+        std::lock_guard lock{owner->mtx};
+        queue = std::exchange(owner->queue, nullptr);
+        owner->pending.store(false, std::memory_order::relaxed);
+    }
+
+    mergeQueued(queue);
+}
+
+static void retainShared(SharedPtrBlockBase* block) noexcept {
+    block->strong.fetch_add(SharedPtrBiasedState::ONE, std::memory_order::relaxed);
+}
+
+static bool releaseShared(SharedPtrBlockBase* block) noexcept {
+    size_t old = block->strong.fetch_sub(SharedPtrBiasedState::ONE, std::memory_order::release);
+    ptrdiff_t count = SharedPtrBiasedState::count(old) - 1;
+
+    if (old & SharedPtrBiasedState::MERGED) {
+        if (count == 0) {
+            std::atomic_thread_fence(std::memory_order::acquire);
+            return true;
+        }
+
+        return false;
+    }
+
+    // we released a reference that the owner counted, it has to merge the counts to find out if this was the last one
+    if (count < 0 && !(old & SharedPtrBiasedState::QUEUED)) {
+        size_t prev = block->strong.fetch_or(SharedPtrBiasedState::QUEUED, std::memory_order::relaxed);
+        if (!(prev & (SharedPtrBiasedState::QUEUED | SharedPtrBiasedState::MERGED))) {
+            enqueue(block);
+        }
+    }
+
+    return false;
+}
+
+void biasedRetain(SharedPtrBlockBase* block) noexcept {
+    auto state = SharedPtrBiasedState::of(block);
+
+    if (state->ownedByCurrentThread()) {
+        state->biased.store(state->biased.load(std::memory_order::relaxed) + 1, std::memory_order::relaxed);
+    } else {
+        retainShared(block);
+    }
+}
+
+bool biasedRelease(SharedPtrBlockBase* block) noexcept {
+    auto state = SharedPtrBiasedState::of(block);
+    if (!state->ownedByCurrentThread()) {
+        return releaseShared(block);
+    }
+
+    size_t count = state->biased.load(std::memory_order::relaxed) - 1;
+    state->biased.store(count, std::memory_order::relaxed);
+    if (count != 0) return false;
+
+    // the owner let go of all of its references, the rest is up to other threads
+    bool dead = merge(block);
+    drainBiasedQueue();
+
+    return dead;
+}
+
+bool biasedTryRetain(SharedPtrBlockBase* block) noexcept {
+    auto state = SharedPtrBiasedState::of(block);
+
+    // only merged blocks can be destroyed, and only the owner merges
+    if (state->ownedByCurrentThread()) {
+        state->biased.store(state->biased.load(std::memory_order::relaxed) + 1, std::memory_order::relaxed);
+        return true;
+    }
+
+    size_t strong = block->strong.load(std::memory_order::relaxed);
+    while (!(strong & SharedPtrBiasedState::MERGED) || SharedPtrBiasedState::count(strong) > 0) {
+        if (block->strong.compare_exchange_weak(strong, strong + SharedPtrBiasedState::ONE, std::memory_order::acquire, std::memory_order::relaxed)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t biasedCount(const SharedPtrBlockBase* block) noexcept {
+    size_t strong = block->strong.load(std::memory_order::relaxed);
+
+    // only exact when called by the owner, or once the counts have been merged
+    ptrdiff_t total = SharedPtrBiasedState::count(strong);
+    if (!(strong & SharedPtrBiasedState::MERGED)) {
+        total += static_cast<ptrdiff_t>(SharedPtrBiasedState::of(block)->biased.load(std::memory_order::relaxed));
+    }
+
+    return total > 0 ? static_cast<size_t>(total) : 0;
+}
+
+}
@@ -0,0 +1,224 @@
+#include <asp/ptr/Symbol.hpp>
+#include <asp/sync/Epoch.hpp>
+#include <asp/sync/RawMutex.hpp>
+#include <mutex>
+
+namespace asp {
+
+using detail::SymbolEntry;
+
+// the table is split into shards by the top bits of the hash, each shard is an open addressing table with linear probing.
+// readers probe without locking, inside an epoch guard. writers lock the shard, replaced tables and collected entries are freed through the epoch.
+static constexpr size_t SHARD_BITS = 6;
+static constexpr size_t SHARDS = 1 << SHARD_BITS;
+static constexpr size_t MIN_CAPACITY = 16;
+
+// set in the refcount of an entry that was collected, lookups that race with the collection see it and ignore the entry
+static constexpr size_t DEAD = static_cast<size_t>(1) << (sizeof(size_t) * 8 - 1);
+
+// marks a slot whose entry was collected, so that probing continues past it
+static SymbolEntry* const TOMBSTONE = reinterpret_cast<SymbolEntry*>(static_cast<uintptr_t>(1));
+
+namespace {
+
+struct Table {
+    size_t mask;
+    std::atomic<SymbolEntry*> slots[];
+
+    static Table* create(size_t capacity) {
+        auto table = static_cast<Table*>(::operator new(sizeof(Table) + sizeof(std::atomic<SymbolEntry*>) * capacity));
+        table->mask = capacity - 1;
+
+        for (size_t i = 0; i < capacity; i++) {
+            new (&table->slots[i]) std::atomic<SymbolEntry*>(nullptr);
+        }
+
+        return table;
+    }
+
+    size_t capacity() const noexcept {
+        return mask + 1;
+    }
+
+    /// Returns the entry for `str`, or null. Tombstones are skipped, dead entries are not.
+    SymbolEntry* probe(size_t hash, std::string_view str) const noexcept {
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            auto entry = slots[i].load(std::memory_order::acquire);
+
+            if (!entry) return nullptr;
+            if (entry == TOMBSTONE) continue;
+
+            if (entry->hash == hash && entry->str.view() == str) {
+                return entry;
+            }
+        }
+    }
+};
+
+struct TableDeleter {
+    void operator()(Table* table) const noexcept {
+        ::operator delete(table);
+    }
+};
+
+struct alignas(64) Shard {
+    RawMutex mtx;
+    std::atomic<Table*> table{nullptr};
+    // amount of entries, and of entries plus tombstones
+    size_t live = 0;
+    size_t used = 0;
+};
+
+}
+
+static constinit Shard g_shards[SHARDS];
+
+static Shard& shardFor(size_t hash) noexcept {
+    return g_shards[hash >> (sizeof(size_t) * 8 - SHARD_BITS)];
+}
+
+static bool tryRetain(SymbolEntry* entry) noexcept {
+    return !(entry->refs.fetch_add(1, std::memory_order::relaxed) & DEAD);
+}
+
+static SymbolEntry* findRetained(Shard& shard, size_t hash, std::string_view str) {
+    auto _guard = epoch::pin();
+
+    auto table = shard.table.load(std::memory_order::acquire);
+    if (!table) return nullptr;
+
+    auto entry = table->probe(hash, str);
+    return entry && tryRetain(entry) ? entry : nullptr;
+}
+
+// rebuilds the table of a locked shard without tombstones, with room for at least one more entry
+static Table* rehash(Shard& shard) {
+    size_t capacity = MIN_CAPACITY;
+    while ((shard.live + 1) * 2 > capacity) {
+        capacity *= 2;
+    }
+
+    auto newTable = Table::create(capacity);
+    auto oldTable = shard.table.load(std::memory_order::relaxed);
+
+    if (oldTable) {
+        for (size_t i = 0; i < oldTable->capacity(); i++) {
+            auto entry = oldTable->slots[i].load(std::memory_order::relaxed);
+            if (!entry || entry == TOMBSTONE) continue;
+
+            size_t j = entry->hash & newTable->mask;
+            while (newTable->slots[j].load(std::memory_order::relaxed)) {
+                j = (j + 1) & newTable->mask;
+            }
+
+            newTable->slots[j].store(entry, std::memory_order::relaxed);
+        }
+    }
+
+    shard.table.store(newTable, std::memory_order::release);
+    shard.used = shard.live;
+
+    if (oldTable) {
+        epoch::defer(oldTable, TableDeleter{});
+    }
+
+    return newTable;
+}
+
+Symbol::Symbol(std::string_view str) {
+    if (str.empty()) return;
+
+    size_t hash = std::hash<std::string_view>{}(str);
+    auto& shard = shardFor(hash);
+
+    if ((m_entry = findRetained(shard, hash, str))) {
+        return;
+    }
+
+    std::lock_guard lock{shard.mtx};
+
+    // another thread might have interned it in the meantime. tables and entries are only replaced or freed under the lock,
+    // so there is no need to pin here
+    auto table = shard.table.load(std::memory_order::relaxed);
+    if (table) {
+        auto entry = table->probe(hash, str);
+        if (entry && tryRetain(entry)) {
+            m_entry = entry;
+            return;
+        }
+    }
+
+    if (!table || (shard.used + 1) * 4 > table->capacity() * 3) {
+        table = rehash(shard);
+    }
+
+    auto entry = new SymbolEntry{hash, 1, BoxedString{str}};
+
+    size_t i = hash & table->mask;
+    while (true) {
+        auto slot = table->slots[i].load(std::memory_order::relaxed);
+        if (!slot || slot == TOMBSTONE) {
+            if (!slot) shard.used++;
+            break;
+        }
+
+        i = (i + 1) & table->mask;
+    }
+
+    table->slots[i].store(entry, std::memory_order::release);
+    shard.live++;
+
+    m_entry = entry;
+}
+
+std::optional<Symbol> Symbol::find(std::string_view str) {
+    if (str.empty()) return Symbol{};
+
+    size_t hash = std::hash<std::string_view>{}(str);
+
+    if (auto entry = findRetained(shardFor(hash), hash, str)) {
+        return Symbol{entry};
+    }
+
+    return std::nullopt;
+}
+
+size_t Symbol::collectUnused() {
+    size_t freed = 0;
+    auto guard = epoch::pin();
+
+    for (auto& shard : g_shards) {
+        std::lock_guard lock{shard.mtx};
+
+        auto table = shard.table.load(std::memory_order::relaxed);
+        if (!table) continue;
+
+        for (size_t i = 0; i < table->capacity(); i++) {
+            auto entry = table->slots[i].load(std::memory_order::relaxed);
+            if (!entry || entry == TOMBSTONE) continue;
+
+            size_t expected = 0;
+            if (entry->refs.compare_exchange_strong(expected, DEAD, std::memory_order::acquire, std::memory_order::relaxed)) {
+                table->slots[i].store(TOMBSTONE, std::memory_order::release);
+                shard.live--;
+                guard.defer(entry);
+                freed++;
+            }
+        }
+    }
+
+    return freed;
+}
+
+size_t Symbol::internedCount() {
+    size_t count = 0;
+
+    for (auto& shard : g_shards) {
+        std::lock_guard lock{shard.mtx};
+        count += shard.live;
+    }
+
+    return count;
+}
+
+}
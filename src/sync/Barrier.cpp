@@ -0,0 +1,70 @@
+#include <asp/sync/Barrier.hpp>
+#include <asp/sync/Backoff.hpp>
+#include <asp/sync/Futex.hpp>
+
+namespace asp {
+
+bool Barrier::arriveImpl(u32& phase) noexcept {
+    phase = m_phase.load(std::memory_order::acquire);
+
+    if (m_arrived.fetch_add(1, std::memory_order::acq_rel) + 1 != m_count) {
+        return false;
+    }
+
+    // last one to arrive, nobody else can touch the barrier until the phase is bumped
+    if (m_completion) {
+        m_completion();
+    }
+
+    m_arrived.store(0, std::memory_order::relaxed);
+    m_phase.fetch_add(1, std::memory_order::seq_cst);
+
+    if (m_sleepers.load(std::memory_order::seq_cst) != 0) {
+        futex::wakeAll(m_phase);
+    }
+
+    return true;
+}
+
+Barrier::ArrivalToken Barrier::arrive() noexcept {
+    u32 phase;
+    this->arriveImpl(phase);
+    return {phase};
+}
+
+bool Barrier::arriveAndWait() noexcept {
+    u32 phase;
+    if (this->arriveImpl(phase)) {
+        return true;
+    }
+
+    this->wait(ArrivalToken{phase});
+    return false;
+}
+
+bool Barrier::waitUntil(ArrivalToken token, const time::Instant& deadline) const noexcept {
+    // phases are usually short, spin for a bit first to avoid the cost of parking and waking
+    Backoff backoff;
+    while (!backoff.isCompleted()) {
+        if (m_phase.load(std::memory_order::acquire) != token.phase) {
+            return true;
+        }
+
+        backoff.snooze();
+    }
+
+    m_sleepers.fetch_add(1, std::memory_order::seq_cst);
+
+    bool completed = true;
+    while (m_phase.load(std::memory_order::seq_cst) == token.phase) {
+        if (!futex::waitUntil(m_phase, token.phase, deadline)) {
+            completed = m_phase.load(std::memory_order::acquire) != token.phase;
+            break;
+        }
+    }
+
+    m_sleepers.fetch_sub(1, std::memory_order::relaxed);
+    return completed;
+}
+
+}
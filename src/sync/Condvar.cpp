@@ -0,0 +1,93 @@
+#include <asp/sync/Condvar.hpp>
+#include <asp/sync/ParkingLot.hpp>
+
+namespace asp {
+
+bool Condvar::waitUntil(RawMutex& mutex, const time::Instant& deadline) noexcept {
+    bool badMutex = false;
+
+    auto result = parking::park(
+        this,
+        [&] {
+            auto current = m_mutex.load(std::memory_order::relaxed);
+
+            if (!current) {
+                m_mutex.store(&mutex, std::memory_order::relaxed);
+            } else if (current != &mutex) {
+                badMutex = true;
+                return false;
+            }
+
+            return true;
+        },
+        [&] {
+            // we are already in the queue, so a notification sent right after this is not lost
+            mutex.unlock();
+        },
+        [&](const void* key, bool wasLastThread) {
+            // if we were requeued onto the mutex, it's the mutex that tracks us now
+            if (key == this && wasLastThread) {
+                m_mutex.store(nullptr, std::memory_order::relaxed);
+            }
+        },
+        deadline
+    );
+
+    ASP_ALWAYS_ASSERT(!badMutex, "a Condvar can only be waited on with one mutex at a time");
+
+    mutex.lock();
+    return result.kind != parking::ParkResult::TimedOut;
+}
+
+void Condvar::notifyOneSlow() noexcept {
+    auto mutex = m_mutex.load(std::memory_order::relaxed);
+
+    parking::unparkRequeue(
+        this,
+        mutex,
+        [&] {
+            if (m_mutex.load(std::memory_order::relaxed) != mutex) {
+                return parking::RequeueOp::Abort;
+            }
+
+            // waking the thread up while the mutex is held would only make it park again on the mutex
+            return mutex->markParkedIfLocked() ? parking::RequeueOp::RequeueOne : parking::RequeueOp::UnparkOne;
+        },
+        [&](parking::RequeueOp, parking::UnparkResult result) -> parking::UnparkToken {
+            if (!result.haveMoreThreads) {
+                m_mutex.store(nullptr, std::memory_order::relaxed);
+            }
+
+            return 0;
+        }
+    );
+}
+
+void Condvar::notifyAllSlow() noexcept {
+    auto mutex = m_mutex.load(std::memory_order::relaxed);
+
+    parking::unparkRequeue(
+        this,
+        mutex,
+        [&] {
+            if (m_mutex.load(std::memory_order::relaxed) != mutex) {
+                return parking::RequeueOp::Abort;
+            }
+
+            // every waiter is leaving our queue
+            m_mutex.store(nullptr, std::memory_order::relaxed);
+
+            // if the mutex is unlocked, wake one thread to take it, and let the rest wait for it on the mutex
+            return mutex->markParkedIfLocked() ? parking::RequeueOp::RequeueAll : parking::RequeueOp::UnparkOneRequeueRest;
+        },
+        [&](parking::RequeueOp op, parking::UnparkResult result) -> parking::UnparkToken {
+            if (op == parking::RequeueOp::UnparkOneRequeueRest && result.requeuedThreads > 0) {
+                mutex->markParked();
+            }
+
+            return 0;
+        }
+    );
+}
+
+}
@@ -0,0 +1,218 @@
+#include <asp/sync/Epoch.hpp>
+#include <asp/sync/SegQueue.hpp>
+#include <atomic>
+#include <vector>
+
+namespace asp::epoch {
+
+// amount of deferred objects a thread collects before handing them off
+static constexpr size_t BAG_CAPACITY = 64;
+// every this many pins, a thread tries to advance the epoch and free expired bags
+static constexpr u32 PINS_BETWEEN_COLLECT = 128;
+static constexpr size_t BAGS_PER_COLLECT = 8;
+
+static constexpr u64 PINNED = 1;
+
+struct Deferred {
+    void* ptr;
+    void (*fn)(void*);
+};
+
+struct SealedBag {
+    u64 epoch;
+    std::vector<Deferred> items;
+};
+
+struct Participant {
+    // (epoch << 1) | PINNED while pinned, 0 otherwise
+    std::atomic<u64> state{0};
+    std::atomic<bool> inUse{true};
+    Participant* next = nullptr;
+
+    // only touched by the owning thread
+    u32 depth = 0;
+    u32 pinCount = 0;
+    std::vector<Deferred> bag;
+};
+
+struct Global {
+    alignas(ASP_CACHE_LINE_SIZE) std::atomic<u64> epoch{0};
+    // participants are never freed, the records of exited threads are reused by new ones
+    std::atomic<Participant*> participants{nullptr};
+    SegQueue<SealedBag*> bags;
+};
+
+static Global& global() {
+    // leaked on purpose, so that threads exiting during static destruction can still unregister
+    static Global* g = new Global;
+    return *g;
+}
+
+struct LocalHandle {
+    Participant* participant = nullptr;
+
+    ~LocalHandle() {
+        unregisterThread();
+    }
+};
+
+static thread_local LocalHandle t_local;
+
+static Participant& local() {
+    if (!t_local.participant) [[unlikely]] {
+        registerThread();
+    }
+
+    return *t_local.participant;
+}
+
+static void sealBag(Participant& p) {
+    if (p.bag.empty()) return;
+
+    auto& g = global();
+
+    // the bag can be freed once every thread has seen an epoch two steps past this one
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    auto sealed = new SealedBag{g.epoch.load(std::memory_order::relaxed), std::move(p.bag)};
+    g.bags.push(sealed);
+
+    p.bag = {};
+    p.bag.reserve(BAG_CAPACITY);
+}
+
+static u64 tryAdvance() {
+    auto& g = global();
+    u64 epoch = g.epoch.load(std::memory_order::relaxed);
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+
+    // the epoch can only be advanced once every pinned thread has observed the current one
+    for (auto p = g.participants.load(std::memory_order::acquire); p; p = p->next) {
+        // acquire pairs with the release store in unpin, everything the thread read while pinned happens before we free anything
+        u64 state = p->state.load(std::memory_order::acquire);
+        if ((state & PINNED) && (state >> 1) != epoch) {
+            return epoch;
+        }
+    }
+
+    if (g.epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order::release, std::memory_order::relaxed)) {
+        return epoch + 1;
+    }
+
+    return epoch;
+}
+
+static void collect() {
+    auto& g = global();
+    u64 epoch = tryAdvance();
+
+    for (size_t i = 0; i < BAGS_PER_COLLECT; i++) {
+        auto bag = g.bags.pop();
+        if (!bag) break;
+
+        if (epoch < (*bag)->epoch + 2) {
+            // bags are sealed in roughly increasing epoch order, so the rest is not expired either
+            g.bags.push(*bag);
+            break;
+        }
+
+        for (auto& item : (*bag)->items) {
+            item.fn(item.ptr);
+        }
+
+        delete *bag;
+    }
+}
+
+Guard pin() {
+    auto& p = local();
+
+    if (p.depth++ == 0) {
+        u64 epoch = global().epoch.load(std::memory_order::relaxed);
+        p.state.store((epoch << 1) | PINNED, std::memory_order::relaxed);
+
+        // the pinned state must be visible before we read any shared pointers
+        std::atomic_thread_fence(std::memory_order::seq_cst);
+
+        if (++p.pinCount % PINS_BETWEEN_COLLECT == 0) {
+            collect();
+        }
+    }
+
+    return Guard{true};
+}
+
+bool isPinned() noexcept {
+    return t_local.participant && t_local.participant->depth > 0;
+}
+
+void Guard::unpin() noexcept {
+    if (!m_pinned) return;
+    m_pinned = false;
+
+    auto& p = *t_local.participant;
+    if (--p.depth == 0) {
+        p.state.store(0, std::memory_order::release);
+    }
+}
+
+void Guard::deferRaw(void* ptr, void (*fn)(void*)) const {
+    ASP_ASSERT(m_pinned, "deferring through an epoch guard that is not pinned");
+
+    auto& p = *t_local.participant;
+    p.bag.push_back(Deferred{ptr, fn});
+
+    if (p.bag.size() >= BAG_CAPACITY) {
+        sealBag(p);
+    }
+}
+
+void Guard::flush() const {
+    sealBag(*t_local.participant);
+    collect();
+}
+
+void registerThread() {
+    if (t_local.participant) return;
+
+    auto& g = global();
+
+    // reuse the record of a thread that has exited
+    for (auto p = g.participants.load(std::memory_order::acquire); p; p = p->next) {
+        bool expected = false;
+        if (!p->inUse.load(std::memory_order::relaxed) && p->inUse.compare_exchange_strong(expected, true, std::memory_order::acquire)) {
+            t_local.participant = p;
+            return;
+        }
+    }
+
+    auto p = new Participant;
+    p->bag.reserve(BAG_CAPACITY);
+
+    auto head = g.participants.load(std::memory_order::relaxed);
+    do {
+        p->next = head;
+    } while (!g.participants.compare_exchange_weak(head, p, std::memory_order::release, std::memory_order::relaxed));
+
+    t_local.participant = p;
+}
+
+void unregisterThread() {
+    auto p = t_local.participant;
+    if (!p) return;
+
+    ASP_ASSERT(p->depth == 0, "unregistering a thread that is still pinned");
+
+    // hand off whatever is left, other threads will free it
+    sealBag(*p);
+
+    p->pinCount = 0;
+    p->state.store(0, std::memory_order::release);
+    p->inUse.store(false, std::memory_order::release);
+    t_local.participant = nullptr;
+}
+
+u64 currentEpoch() noexcept {
+    return global().epoch.load(std::memory_order::relaxed);
+}
+
+}
@@ -0,0 +1,157 @@
+#include <asp/sync/LockProfiler.hpp>
+#include <asp/sync/Backoff.hpp>
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace asp::lockprof {
+
+// don't reserve the registry if nothing can ever be recorded into it
+static constexpr size_t REGISTRY_SIZE = enabled() ? 4096 : 1;
+static constexpr u32 EMPTY = 0;
+static constexpr u32 REGISTERING = 1;
+static constexpr u32 READY = 2;
+
+static Site g_sites[REGISTRY_SIZE];
+static Site g_overflow;
+
+static bool sameLocation(const std::source_location& a, const std::source_location& b) noexcept {
+    if (a.line() != b.line() || a.column() != b.column()) {
+        return false;
+    }
+
+    // identical file names may be separate string literals in different translation units
+    return a.file_name() == b.file_name() || std::strcmp(a.file_name(), b.file_name()) == 0;
+}
+
+static void storeMax(std::atomic<u64>& target, u64 value) noexcept {
+    u64 current = target.load(std::memory_order::relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order::relaxed)) {}
+}
+
+void Site::recordAcquire(bool contended, const time::Duration& wait) noexcept {
+    m_acquisitions.fetch_add(1, std::memory_order::relaxed);
+
+    if (contended) {
+        u64 nanos = wait.nanos();
+        m_contended.fetch_add(1, std::memory_order::relaxed);
+        m_waitNanos.fetch_add(nanos, std::memory_order::relaxed);
+        storeMax(m_maxWaitNanos, nanos);
+    }
+}
+
+void Site::recordHold(const time::Duration& hold) noexcept {
+    u64 nanos = hold.nanos();
+    m_holdNanos.fetch_add(nanos, std::memory_order::relaxed);
+    storeMax(m_maxHoldNanos, nanos);
+}
+
+Site& site(const std::source_location& location) noexcept {
+    // the file name is not hashed, since it may not be the same pointer for the same call site
+    size_t hash = (size_t)location.line() * 0x9e3779b1u + location.column();
+
+    for (size_t i = 0; i < REGISTRY_SIZE; i++) {
+        auto& slot = g_sites[(hash + i) % REGISTRY_SIZE];
+        u32 state = slot.m_state.load(std::memory_order::acquire);
+
+        if (state == EMPTY) {
+            if (slot.m_state.compare_exchange_strong(state, REGISTERING, std::memory_order::acquire)) {
+                slot.m_location = location;
+                slot.m_state.store(READY, std::memory_order::release);
+                return slot;
+            }
+        }
+
+        // somebody else is registering this slot, wait to see which site it is
+        while (state == REGISTERING) {
+            cpuRelax();
+            state = slot.m_state.load(std::memory_order::acquire);
+        }
+
+        if (sameLocation(slot.m_location, location)) {
+            return slot;
+        }
+    }
+
+    return g_overflow;
+}
+
+std::vector<SiteStats> snapshot() {
+    std::vector<SiteStats> out;
+
+    auto collect = [&](const Site& site, std::source_location location) {
+        u64 acquisitions = site.m_acquisitions.load(std::memory_order::relaxed);
+        if (acquisitions == 0) return;
+
+        out.push_back(SiteStats {
+            .location = location,
+            .acquisitions = acquisitions,
+            .contended = site.m_contended.load(std::memory_order::relaxed),
+            .totalWait = time::Duration::fromNanos(site.m_waitNanos.load(std::memory_order::relaxed)),
+            .maxWait = time::Duration::fromNanos(site.m_maxWaitNanos.load(std::memory_order::relaxed)),
+            .totalHold = time::Duration::fromNanos(site.m_holdNanos.load(std::memory_order::relaxed)),
+            .maxHold = time::Duration::fromNanos(site.m_maxHoldNanos.load(std::memory_order::relaxed)),
+        });
+    };
+
+    for (auto& site : g_sites) {
+        if (site.m_state.load(std::memory_order::acquire) == READY) {
+            collect(site, site.m_location);
+        }
+    }
+
+    collect(g_overflow, std::source_location{});
+
+    std::sort(out.begin(), out.end(), [](const SiteStats& a, const SiteStats& b) {
+        return a.totalWait > b.totalWait;
+    });
+
+    return out;
+}
+
+std::string dump(size_t maxSites) {
+    if constexpr (!enabled()) {
+        return "lock profiling is disabled, build with ASP_LOCK_PROFILING to enable it\n";
+    }
+
+    auto sites = snapshot();
+    std::string out;
+
+    for (size_t i = 0; i < sites.size() && i < maxSites; i++) {
+        auto& s = sites[i];
+        double contendedPct = 100.0 * (double)s.contended / (double)s.acquisitions;
+
+        fmt::format_to(
+            std::back_inserter(out),
+            "{}:{} ({}): {} acquisitions, {} contended ({:.1f}%), wait {} total / {} max, hold {} total / {} max\n",
+            s.location.line() ? s.location.file_name() : "<other>", s.location.line(), s.location.function_name(),
+            s.acquisitions, s.contended, contendedPct, s.totalWait, s.maxWait, s.totalHold, s.maxHold
+        );
+    }
+
+    if (sites.size() > maxSites) {
+        fmt::format_to(std::back_inserter(out), "... and {} more call sites\n", sites.size() - maxSites);
+    }
+
+    return out;
+}
+
+void reset() {
+    auto clear = [](Site& site) {
+        site.m_acquisitions.store(0, std::memory_order::relaxed);
+        site.m_contended.store(0, std::memory_order::relaxed);
+        site.m_waitNanos.store(0, std::memory_order::relaxed);
+        site.m_maxWaitNanos.store(0, std::memory_order::relaxed);
+        site.m_holdNanos.store(0, std::memory_order::relaxed);
+        site.m_maxHoldNanos.store(0, std::memory_order::relaxed);
+    };
+
+    for (auto& site : g_sites) {
+        clear(site);
+    }
+
+    clear(g_overflow);
+}
+
+}
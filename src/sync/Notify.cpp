@@ -0,0 +1,155 @@
+#include <asp/sync/Notify.hpp>
+#include <asp/sync/ParkingLot.hpp>
+#include <asp/detail/config.hpp>
+
+namespace asp {
+
+static constexpr u8 PERMIT = 1;
+static constexpr u8 PARKED = 2;
+static constexpr u8 EPOCH = 4;
+static constexpr u8 EPOCH_MASK = 0xfc;
+
+static int epochOf(u8 state) noexcept { return state >> 2; }
+
+// unpark tokens, notifyAll hands out the new epoch plus one so that it is never zero
+static constexpr parking::UnparkToken NOTIFY_ONE = 0;
+
+void Notify::wait() {
+    this->waitImpl(Instant::farFuture(), -1);
+}
+
+bool Notify::wait(const time::Duration& timeout) {
+    return this->waitImpl(Instant::now() + timeout, -1);
+}
+
+bool Notify::waitUntil(const time::Instant& deadline) {
+    return this->waitImpl(deadline, -1);
+}
+
+bool Notify::wait(const time::Duration& timeout, asp::FunctionRef<bool()> predicate) {
+    // if timeout is zero, we wait indefinitely
+    auto deadline = timeout.isZero() ? Instant::farFuture() : Instant::now() + timeout;
+
+    while (true) {
+        // take the epoch before checking the predicate, so that a `notifyAll` in between is not missed
+        int epoch = epochOf(m_state.load(std::memory_order::acquire));
+
+        if (predicate()) {
+            return true;
+        }
+
+        if (!this->waitImpl(deadline, epoch)) {
+            return predicate();
+        }
+    }
+}
+
+bool Notify::waitImpl(const time::Instant& deadline, int epoch) {
+    bool infinite = deadline == Instant::farFuture();
+    u8 state = m_state.load(std::memory_order::relaxed);
+
+    if (epoch == -1) {
+        epoch = epochOf(state);
+    }
+
+    while (true) {
+        if (state & PERMIT) {
+            if (m_state.compare_exchange_weak(state, state & ~PERMIT, std::memory_order::acquire, std::memory_order::relaxed)) {
+                return true;
+            }
+            continue;
+        }
+
+        if (epochOf(state) != epoch) {
+            std::atomic_thread_fence(std::memory_order::acquire);
+            return true;
+        }
+
+        if (!infinite && Instant::now() >= deadline) {
+            return false;
+        }
+
+        // let notifiers know they have to go through the parking lot
+        if (!(state & PARKED)) {
+            if (!m_state.compare_exchange_weak(state, state | PARKED, std::memory_order::relaxed, std::memory_order::relaxed)) {
+                continue;
+            }
+        }
+
+        auto result = parking::park(
+            this,
+            [&] {
+                u8 s = m_state.load(std::memory_order::relaxed);
+                return (s & PARKED) && !(s & PERMIT) && epochOf(s) == epoch;
+            },
+            [] {},
+            [&](const void*, bool wasLastThread) {
+                if (wasLastThread) {
+                    m_state.fetch_and(~PARKED, std::memory_order::relaxed);
+                }
+            },
+            deadline
+        );
+
+        switch (result.kind) {
+            case parking::ParkResult::Unparked:
+                // a notifyAll that bumped the epoch to the one we started with is not meant for us
+                if (result.token == NOTIFY_ONE || (int)result.token - 1 != epoch) {
+                    return true;
+                }
+                break;
+
+            case parking::ParkResult::TimedOut:
+                return false;
+
+            case parking::ParkResult::Invalid:
+                break;
+        }
+
+        state = m_state.load(std::memory_order::relaxed);
+    }
+}
+
+void Notify::notifyOne() {
+    u8 state = m_state.load(std::memory_order::relaxed);
+
+    // nobody is parked, store a permit for the next waiter
+    while (!(state & PARKED)) {
+        // still publish our writes to whoever consumes the permit, even if one is already stored
+        if (m_state.compare_exchange_weak(state, state | PERMIT, std::memory_order::release, std::memory_order::relaxed)) {
+            return;
+        }
+    }
+
+    parking::unparkOne(this, [this](parking::UnparkResult result) {
+        if (result.unparkedThreads == 0) {
+            // the waiter has not enqueued itself yet, its validation will fail and it will take the permit
+            m_state.fetch_or(PERMIT, std::memory_order::release);
+        }
+
+        if (!result.haveMoreThreads) {
+            m_state.fetch_and(~PARKED, std::memory_order::relaxed);
+        }
+
+        return NOTIFY_ONE;
+    });
+}
+
+void Notify::notifyAll() {
+    u8 state = m_state.load(std::memory_order::relaxed);
+    u8 newState;
+
+    do {
+        u8 epoch = (u8)(state + EPOCH) & EPOCH_MASK;
+
+        // every parked waiter is woken up, so an outstanding permit is dropped.
+        // with nobody parked the epoch is still bumped, to wake up predicate waits that are about to sleep
+        newState = (state & PARKED) ? epoch : (u8)(epoch | (state & PERMIT));
+    } while (!m_state.compare_exchange_weak(state, newState, std::memory_order::release, std::memory_order::relaxed));
+
+    if (state & PARKED) {
+        parking::unparkAll(this, (parking::UnparkToken)epochOf(newState) + 1);
+    }
+}
+
+}
@@ -0,0 +1,43 @@
+#include <asp/sync/OnceCell.hpp>
+#include <asp/sync/ParkingLot.hpp>
+
+namespace asp::detail {
+
+bool OnceState::begin() noexcept {
+    u8 state = m_state.load(std::memory_order::acquire);
+
+    while (true) {
+        switch (state) {
+            case COMPLETE:
+                return false;
+
+            case UNINIT:
+                if (m_state.compare_exchange_weak(state, RUNNING, std::memory_order::acquire, std::memory_order::acquire)) {
+                    return true;
+                }
+                break;
+
+            case RUNNING:
+                // let the initializing thread know it has to wake us up
+                if (!m_state.compare_exchange_weak(state, RUNNING_WAITERS, std::memory_order::acquire, std::memory_order::acquire)) {
+                    break;
+                }
+                [[fallthrough]];
+
+            case RUNNING_WAITERS:
+                parking::park(this, [this] {
+                    return m_state.load(std::memory_order::relaxed) == RUNNING_WAITERS;
+                });
+                state = m_state.load(std::memory_order::acquire);
+                break;
+        }
+    }
+}
+
+void OnceState::finish(u8 state) noexcept {
+    if (m_state.exchange(state, std::memory_order::release) == RUNNING_WAITERS) {
+        parking::unparkAll(this);
+    }
+}
+
+}
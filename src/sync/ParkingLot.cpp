@@ -0,0 +1,402 @@
+#include <asp/sync/ParkingLot.hpp>
+#include <asp/sync/Backoff.hpp>
+#include <asp/sync/Futex.hpp>
+#include <atomic>
+
+namespace asp::parking {
+
+// The bucket lock can't park through the parking lot itself, so it's a plain futex mutex.
+// Critical sections are a handful of pointer operations, so it spins for a bit before sleeping.
+class BucketLock {
+public:
+    void lock() noexcept {
+        u32 expected = UNLOCKED;
+        if (!m_state.compare_exchange_strong(expected, LOCKED, std::memory_order::acquire, std::memory_order::relaxed)) [[unlikely]] {
+            this->lockSlow();
+        }
+    }
+
+    void unlock() noexcept {
+        if (m_state.exchange(UNLOCKED, std::memory_order::release) == CONTENDED) [[unlikely]] {
+            futex::wakeOne(m_state);
+        }
+    }
+
+private:
+    static constexpr u32 UNLOCKED = 0;
+    static constexpr u32 LOCKED = 1;
+    static constexpr u32 CONTENDED = 2;
+
+    std::atomic<u32> m_state{UNLOCKED};
+
+    ASP_COLD void lockSlow() noexcept {
+        Backoff backoff;
+
+        for (u32 i = 0; i < 10; i++) {
+            u32 state = m_state.load(std::memory_order::relaxed);
+
+            if (state == UNLOCKED) {
+                if (m_state.compare_exchange_weak(state, LOCKED, std::memory_order::acquire, std::memory_order::relaxed)) {
+                    return;
+                }
+            } else if (state == CONTENDED) {
+                break;
+            }
+
+            backoff.spin();
+        }
+
+        while (m_state.exchange(CONTENDED, std::memory_order::acquire) != UNLOCKED) {
+            futex::wait(m_state, CONTENDED);
+        }
+    }
+};
+
+struct ThreadData {
+    // only changed with the bucket locked, but read by the parked thread itself when it times out
+    std::atomic<const void*> key{nullptr};
+    ThreadData* next = nullptr;
+    UnparkToken token = 0;
+    // 1 while parked, set to 0 by the unparking thread with the bucket locked
+    std::atomic<u32> parked{0};
+};
+
+struct alignas(ASP_CACHE_LINE_SIZE) Bucket {
+    BucketLock lock;
+    ThreadData* head = nullptr;
+    ThreadData* tail = nullptr;
+
+    void enqueue(ThreadData* td) noexcept {
+        td->next = nullptr;
+
+        if (tail) {
+            tail->next = td;
+        } else {
+            head = td;
+        }
+
+        tail = td;
+    }
+
+    void remove(ThreadData* td, ThreadData* prev) noexcept {
+        if (prev) {
+            prev->next = td->next;
+        } else {
+            head = td->next;
+        }
+
+        if (tail == td) {
+            tail = prev;
+        }
+    }
+
+    bool hasKey(const void* key, ThreadData* from) const noexcept {
+        for (auto td = from; td; td = td->next) {
+            if (td->key.load(std::memory_order::relaxed) == key) return true;
+        }
+
+        return false;
+    }
+};
+
+static constexpr usize BUCKET_COUNT = 512;
+static Bucket g_buckets[BUCKET_COUNT];
+
+static Bucket& bucketFor(const void* key) noexcept {
+    // fibonacci hashing, the low bits of addresses are mostly zero
+    u64 hash = (u64)(uintptr_t)key * 0x9e3779b97f4a7c15ull;
+    return g_buckets[hash >> (64 - 9)];
+}
+
+static_assert(BUCKET_COUNT == 1 << 9);
+
+static ThreadData& threadData() noexcept {
+    static thread_local ThreadData td;
+    return td;
+}
+
+// Locks the bucket that the thread is currently parked in, which may change under us if it is requeued
+static Bucket& lockParkedBucket(ThreadData& td) noexcept {
+    while (true) {
+        auto key = td.key.load(std::memory_order::relaxed);
+        auto& bucket = bucketFor(key);
+        bucket.lock.lock();
+
+        if (td.key.load(std::memory_order::relaxed) == key) {
+            return bucket;
+        }
+
+        bucket.lock.unlock();
+    }
+}
+
+// Locks two buckets in a consistent order, so that two requeues in opposite directions can't deadlock
+static void lockPair(Bucket& a, Bucket& b) noexcept {
+    if (&a == &b) {
+        a.lock.lock();
+    } else if (&a < &b) {
+        a.lock.lock();
+        b.lock.lock();
+    } else {
+        b.lock.lock();
+        a.lock.lock();
+    }
+}
+
+static void unlockPair(Bucket& a, Bucket& b) noexcept {
+    a.lock.unlock();
+    if (&a != &b) {
+        b.lock.unlock();
+    }
+}
+
+static ParkResult parkImpl(
+    const void* key,
+    FunctionRef<bool()> validate,
+    FunctionRef<void()>* beforeSleep,
+    FunctionRef<void(const void*, bool)>* timedOut,
+    const time::Instant& deadline
+) {
+    auto& bucket = bucketFor(key);
+    auto& td = threadData();
+
+    bucket.lock.lock();
+
+    if (!validate()) {
+        bucket.lock.unlock();
+        return {ParkResult::Invalid};
+    }
+
+    td.key.store(key, std::memory_order::relaxed);
+    td.token = 0;
+    td.parked.store(1, std::memory_order::relaxed);
+    bucket.enqueue(&td);
+
+    bucket.lock.unlock();
+
+    if (beforeSleep) {
+        (*beforeSleep)();
+    }
+
+    while (td.parked.load(std::memory_order::acquire) != 0) {
+        if (futex::waitUntil(td.parked, 1, deadline)) {
+            continue;
+        }
+
+        // timed out, but we may have been unparked right before taking the lock
+        auto& current = lockParkedBucket(td);
+
+        if (td.parked.load(std::memory_order::relaxed) != 0) {
+            auto currentKey = td.key.load(std::memory_order::relaxed);
+
+            ThreadData* prev = nullptr;
+            for (auto cur = current.head; cur != &td; cur = cur->next) {
+                prev = cur;
+            }
+
+            current.remove(&td, prev);
+
+            if (timedOut) {
+                (*timedOut)(currentKey, !current.hasKey(currentKey, current.head));
+            }
+
+            td.parked.store(0, std::memory_order::relaxed);
+            current.lock.unlock();
+
+            return {ParkResult::TimedOut};
+        }
+
+        current.lock.unlock();
+    }
+
+    return {ParkResult::Unparked, td.token};
+}
+
+ParkResult park(
+    const void* key,
+    FunctionRef<bool()> validate,
+    FunctionRef<void()> beforeSleep,
+    FunctionRef<void(const void*, bool)> timedOut,
+    const time::Instant& deadline
+) {
+    return parkImpl(key, validate, &beforeSleep, &timedOut, deadline);
+}
+
+ParkResult park(const void* key, FunctionRef<bool()> validate, const time::Instant& deadline) {
+    return parkImpl(key, validate, nullptr, nullptr, deadline);
+}
+
+UnparkResult unparkOne(const void* key, FunctionRef<UnparkToken(UnparkResult)> callback) {
+    auto& bucket = bucketFor(key);
+    bucket.lock.lock();
+
+    ThreadData* prev = nullptr;
+    ThreadData* td = bucket.head;
+
+    while (td && td->key.load(std::memory_order::relaxed) != key) {
+        prev = td;
+        td = td->next;
+    }
+
+    UnparkResult result;
+
+    if (td) {
+        bucket.remove(td, prev);
+
+        result.unparkedThreads = 1;
+        result.haveMoreThreads = bucket.hasKey(key, td->next);
+    }
+
+    UnparkToken token = callback(result);
+
+    if (td) {
+        td->token = token;
+        td->parked.store(0, std::memory_order::release);
+    }
+
+    bucket.lock.unlock();
+
+    if (td) {
+        // the thread may have already seen `parked == 0` and exited, but waking an address nobody waits on is harmless
+        futex::wakeOne(td->parked);
+    }
+
+    return result;
+}
+
+usize unparkAll(const void* key, UnparkToken token) {
+    auto& bucket = bucketFor(key);
+    bucket.lock.lock();
+
+    // unlink all matching threads first, and only wake them once the bucket is unlocked
+    ThreadData* woken = nullptr;
+    ThreadData* prev = nullptr;
+    ThreadData* td = bucket.head;
+    usize count = 0;
+
+    while (td) {
+        auto next = td->next;
+
+        if (td->key.load(std::memory_order::relaxed) == key) {
+            bucket.remove(td, prev);
+            td->next = woken;
+            woken = td;
+            count++;
+        } else {
+            prev = td;
+        }
+
+        td = next;
+    }
+
+    // the woken threads may return and park again as soon as `parked` is cleared, so read everything we need before that
+    const std::atomic<u32>* toWake[64];
+    usize pending = 0;
+
+    for (auto cur = woken; cur;) {
+        auto next = cur->next;
+
+        cur->token = token;
+        cur->parked.store(0, std::memory_order::release);
+
+        if (pending < 64) {
+            toWake[pending++] = &cur->parked;
+        } else {
+            futex::wakeOne(cur->parked);
+        }
+
+        cur = next;
+    }
+
+    bucket.lock.unlock();
+
+    for (usize i = 0; i < pending; i++) {
+        futex::wakeOne(*toWake[i]);
+    }
+
+    return count;
+}
+
+UnparkResult unparkRequeue(
+    const void* from,
+    const void* to,
+    FunctionRef<RequeueOp()> validate,
+    FunctionRef<UnparkToken(RequeueOp, UnparkResult)> callback
+) {
+    auto& fromBucket = bucketFor(from);
+    auto& toBucket = bucketFor(to);
+    lockPair(fromBucket, toBucket);
+
+    UnparkResult result;
+    RequeueOp op = validate();
+
+    if (op == RequeueOp::Abort) {
+        unlockPair(fromBucket, toBucket);
+        return result;
+    }
+
+    // unlink everything first, the two buckets may be the same one
+    ThreadData* wake = nullptr;
+    ThreadData* requeueHead = nullptr;
+    ThreadData* requeueTail = nullptr;
+    ThreadData* prev = nullptr;
+    ThreadData* td = fromBucket.head;
+
+    while (td) {
+        auto next = td->next;
+
+        bool unpark = op == RequeueOp::UnparkOne || op == RequeueOp::UnparkOneRequeueRest;
+        bool requeue = op == RequeueOp::UnparkOneRequeueRest || op == RequeueOp::RequeueAll
+            || (op == RequeueOp::RequeueOne && result.requeuedThreads == 0);
+
+        if (td->key.load(std::memory_order::relaxed) != from) {
+            prev = td;
+        } else if (unpark && !wake) {
+            fromBucket.remove(td, prev);
+            wake = td;
+        } else if (requeue) {
+            fromBucket.remove(td, prev);
+            td->key.store(to, std::memory_order::relaxed);
+            td->next = nullptr;
+
+            if (requeueTail) {
+                requeueTail->next = td;
+            } else {
+                requeueHead = td;
+            }
+
+            requeueTail = td;
+            result.requeuedThreads++;
+        } else {
+            result.haveMoreThreads = true;
+            prev = td;
+        }
+
+        td = next;
+    }
+
+    for (auto cur = requeueHead; cur;) {
+        auto next = cur->next;
+        toBucket.enqueue(cur);
+        cur = next;
+    }
+
+    result.unparkedThreads = wake ? 1 : 0;
+
+    UnparkToken token = callback(op, result);
+
+    if (wake) {
+        wake->token = token;
+        wake->parked.store(0, std::memory_order::release);
+    }
+
+    unlockPair(fromBucket, toBucket);
+
+    if (wake) {
+        futex::wakeOne(wake->parked);
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,57 @@
+#include <asp/sync/RawMutex.hpp>
+#include <asp/sync/Backoff.hpp>
+#include <asp/sync/ParkingLot.hpp>
+
+namespace asp {
+
+// Amount of backoff rounds before parking, roughly a few microseconds of spinning
+static constexpr u32 SPIN_ROUNDS = 10;
+
+void RawMutex::lockSlow() noexcept {
+    Backoff backoff;
+    u32 spins = 0;
+    u8 state = m_state.load(std::memory_order::relaxed);
+
+    while (true) {
+        if (!(state & LOCKED)) {
+            if (m_state.compare_exchange_weak(state, state | LOCKED, std::memory_order::acquire, std::memory_order::relaxed)) {
+                return;
+            }
+            continue;
+        }
+
+        // spin while the lock is held but nobody is parked, the holder is likely to release it soon
+        if (!(state & PARKED) && spins < SPIN_ROUNDS) {
+            backoff.spin();
+            spins++;
+            state = m_state.load(std::memory_order::relaxed);
+            continue;
+        }
+
+        // make sure the unlocking thread knows to unpark us
+        if (!(state & PARKED)) {
+            if (!m_state.compare_exchange_weak(state, state | PARKED, std::memory_order::relaxed, std::memory_order::relaxed)) {
+                continue;
+            }
+        }
+
+        parking::park(this, [this] {
+            return m_state.load(std::memory_order::relaxed) == (LOCKED | PARKED);
+        });
+
+        // unparked, or the lock state changed before we could park, try again from the start
+        spins = 0;
+        backoff.reset();
+        state = m_state.load(std::memory_order::relaxed);
+    }
+}
+
+void RawMutex::unlockSlow() noexcept {
+    parking::unparkOne(this, [this](parking::UnparkResult result) -> parking::UnparkToken {
+        // runs with the queue locked, so no thread can park in between
+        m_state.store(result.haveMoreThreads ? PARKED : UNLOCKED, std::memory_order::release);
+        return 0;
+    });
+}
+
+}
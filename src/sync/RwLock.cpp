@@ -0,0 +1,247 @@
+#include <asp/sync/RwLock.hpp>
+#include <asp/sync/Backoff.hpp>
+#include <asp/sync/Futex.hpp>
+#include <asp/thread/Thread.hpp>
+#include <asp/detail/config.hpp>
+
+namespace asp {
+
+// RawRwLock
+
+template <typename F>
+u32 RawRwLock::spinUntil(F&& f) noexcept {
+    u32 spins = 100;
+
+    while (true) {
+        u32 state = m_state.load(std::memory_order::relaxed);
+        if (f(state) || spins == 0) {
+            return state;
+        }
+
+        cpuRelax();
+        spins--;
+    }
+}
+
+void RawRwLock::lockSharedSlow() noexcept {
+    auto spinRead = [this] {
+        return this->spinUntil([](u32 state) {
+            return !isWriteLocked(state) || hasReadersWaiting(state) || hasWritersWaiting(state);
+        });
+    };
+
+    u32 state = spinRead();
+
+    while (true) {
+        if (isReadLockable(state)) {
+            if (m_state.compare_exchange_weak(state, state + READ_LOCKED, std::memory_order::acquire, std::memory_order::relaxed)) {
+                return;
+            }
+            continue;
+        }
+
+        ASP_ALWAYS_ASSERT((state & MASK) != MAX_READERS, "too many readers on a RwLock");
+
+        // make sure the waiting bit is set before going to sleep
+        if (!hasReadersWaiting(state)) {
+            if (!m_state.compare_exchange_strong(state, state | READERS_WAITING, std::memory_order::relaxed, std::memory_order::relaxed)) {
+                continue;
+            }
+        }
+
+        futex::wait(m_state, state | READERS_WAITING);
+        state = spinRead();
+    }
+}
+
+void RawRwLock::lockSlow() noexcept {
+    auto spinWrite = [this] {
+        return this->spinUntil([](u32 state) {
+            return isUnlocked(state) || hasWritersWaiting(state);
+        });
+    };
+
+    u32 state = spinWrite();
+    u32 otherWritersWaiting = 0;
+
+    while (true) {
+        if (isUnlocked(state)) {
+            if (m_state.compare_exchange_weak(state, state | WRITE_LOCKED | otherWritersWaiting, std::memory_order::acquire, std::memory_order::relaxed)) {
+                return;
+            }
+            continue;
+        }
+
+        if (!hasWritersWaiting(state)) {
+            if (!m_state.compare_exchange_strong(state, state | WRITERS_WAITING, std::memory_order::relaxed, std::memory_order::relaxed)) {
+                continue;
+            }
+        }
+
+        // other writers may be waiting as well now, keep the bit set once we acquire the lock
+        otherWritersWaiting = WRITERS_WAITING;
+
+        u32 seq = m_writerNotify.load(std::memory_order::acquire);
+
+        // don't sleep if the lock was released, or the waiting bit got cleared by a waking writer
+        state = m_state.load(std::memory_order::relaxed);
+        if (isUnlocked(state) || !hasWritersWaiting(state)) {
+            continue;
+        }
+
+        futex::wait(m_writerNotify, seq);
+        state = spinWrite();
+    }
+}
+
+void RawRwLock::wakeWriterOrReaders(u32 state) noexcept {
+    // only writers waiting
+    if (state == WRITERS_WAITING) {
+        if (m_state.compare_exchange_strong(state, 0, std::memory_order::relaxed, std::memory_order::relaxed)) {
+            this->wakeWriter();
+            return;
+        }
+    }
+
+    // both readers and writers waiting, leave the readers waiting and wake a writer
+    if (state == (READERS_WAITING | WRITERS_WAITING)) {
+        if (!m_state.compare_exchange_strong(state, READERS_WAITING, std::memory_order::relaxed, std::memory_order::relaxed)) {
+            // somebody locked it in the meantime, they will take care of waking
+            return;
+        }
+
+        if (this->wakeWriter()) {
+            return;
+        }
+
+        // no writer was actually woken up, so wake up the readers instead
+        state = READERS_WAITING;
+    }
+
+    // only readers waiting
+    if (state == READERS_WAITING) {
+        if (m_state.compare_exchange_strong(state, 0, std::memory_order::relaxed, std::memory_order::relaxed)) {
+            futex::wakeAll(m_state);
+        }
+    }
+}
+
+bool RawRwLock::wakeWriter() noexcept {
+    m_writerNotify.fetch_add(1, std::memory_order::release);
+    return futex::wakeOne(m_writerNotify);
+}
+
+// RawShardedRwLock
+
+static constexpr u32 WRITER = 1;
+static constexpr u32 WRITER_READERS_WAITING = 2;
+
+RawShardedRwLock::RawShardedRwLock() {
+    u32 count = cpuShardCount();
+    m_slots = std::make_unique<Slot[]>(count);
+    m_slotMask = count - 1;
+}
+
+bool RawShardedRwLock::tryEnterSlot(u32 slot) noexcept {
+    auto& readers = m_slots[slot].readers;
+    readers.fetch_add(1, std::memory_order::seq_cst);
+
+    if (m_writer.load(std::memory_order::seq_cst) == 0) [[likely]] {
+        return true;
+    }
+
+    // a writer is active, back out so it can make progress
+    if (readers.fetch_sub(1, std::memory_order::seq_cst) == 1) {
+        this->wakeSlot(slot);
+    }
+
+    return false;
+}
+
+RawShardedRwLock::ReadToken RawShardedRwLock::lockShared() noexcept {
+    u32 slot = currentCpu() & m_slotMask;
+    Backoff backoff;
+
+    while (!this->tryEnterSlot(slot)) {
+        u32 writer = m_writer.load(std::memory_order::relaxed);
+        if (writer == 0) continue;
+
+        if (!backoff.isCompleted()) {
+            backoff.snooze();
+            continue;
+        }
+
+        if (!(writer & WRITER_READERS_WAITING)) {
+            if (!m_writer.compare_exchange_strong(writer, writer | WRITER_READERS_WAITING, std::memory_order::relaxed, std::memory_order::relaxed)) {
+                continue;
+            }
+        }
+
+        futex::wait(m_writer, writer | WRITER_READERS_WAITING);
+    }
+
+    return {slot};
+}
+
+std::optional<RawShardedRwLock::ReadToken> RawShardedRwLock::tryLockShared() noexcept {
+    u32 slot = currentCpu() & m_slotMask;
+    if (!this->tryEnterSlot(slot)) {
+        return std::nullopt;
+    }
+
+    return ReadToken{slot};
+}
+
+void RawShardedRwLock::lock() noexcept {
+    m_writerLock.lock();
+
+    // from now on, new readers back out, wait for the existing ones to leave
+    m_writer.store(WRITER, std::memory_order::seq_cst);
+
+    for (u32 i = 0; i <= m_slotMask; i++) {
+        auto& readers = m_slots[i].readers;
+        Backoff backoff;
+
+        while (true) {
+            u32 count = readers.load(std::memory_order::seq_cst);
+            if (count == 0) break;
+
+            if (!backoff.isCompleted()) {
+                backoff.snooze();
+            } else {
+                futex::wait(readers, count);
+            }
+        }
+    }
+}
+
+bool RawShardedRwLock::tryLock() noexcept {
+    if (!m_writerLock.tryLock()) {
+        return false;
+    }
+
+    m_writer.store(WRITER, std::memory_order::seq_cst);
+
+    for (u32 i = 0; i <= m_slotMask; i++) {
+        if (m_slots[i].readers.load(std::memory_order::seq_cst) != 0) {
+            this->unlock();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void RawShardedRwLock::unlock() noexcept {
+    if (m_writer.exchange(0, std::memory_order::seq_cst) & WRITER_READERS_WAITING) {
+        futex::wakeAll(m_writer);
+    }
+
+    m_writerLock.unlock();
+}
+
+void RawShardedRwLock::wakeSlot(u32 slot) noexcept {
+    futex::wakeOne(m_slots[slot].readers);
+}
+
+}
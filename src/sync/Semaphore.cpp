@@ -0,0 +1,48 @@
+#include <asp/sync/Semaphore.hpp>
+#include <asp/sync/Futex.hpp>
+
+namespace asp {
+
+void Semaphore::release(u32 count) noexcept {
+    m_permits.fetch_add(count, std::memory_order::seq_cst);
+
+    // seq_cst pairs with the waiter registering itself and then checking the permits
+    if (m_waiters.load(std::memory_order::seq_cst) == 0) [[likely]] {
+        return;
+    }
+
+    if (count == 1) {
+        futex::wakeOne(m_permits);
+    } else {
+        futex::wakeAll(m_permits);
+    }
+}
+
+bool Semaphore::acquireSlow(const time::Instant& deadline) noexcept {
+    m_waiters.fetch_add(1, std::memory_order::seq_cst);
+
+    bool acquired = false;
+
+    while (true) {
+        u32 permits = m_permits.load(std::memory_order::seq_cst);
+
+        if (permits > 0) {
+            if (m_permits.compare_exchange_weak(permits, permits - 1, std::memory_order::acquire, std::memory_order::relaxed)) {
+                acquired = true;
+                break;
+            }
+            continue;
+        }
+
+        if (!futex::waitUntil(m_permits, 0, deadline)) {
+            // one last try, a permit may have been released right as we timed out
+            acquired = this->tryAcquire();
+            break;
+        }
+    }
+
+    m_waiters.fetch_sub(1, std::memory_order::relaxed);
+    return acquired;
+}
+
+}
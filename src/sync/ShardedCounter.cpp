@@ -0,0 +1,32 @@
+#include <asp/sync/ShardedCounter.hpp>
+#include <asp/thread/Thread.hpp>
+
+namespace asp {
+
+ShardedCounter::ShardedCounter() {
+    u32 count = cpuShardCount();
+    m_slots = std::make_unique<Slot[]>(count);
+    m_slotMask = count - 1;
+}
+
+void ShardedCounter::add(i64 n) noexcept {
+    m_slots[currentCpu() & m_slotMask].value.fetch_add(n, std::memory_order::relaxed);
+}
+
+i64 ShardedCounter::load() const noexcept {
+    i64 sum = 0;
+
+    for (u32 i = 0; i <= m_slotMask; i++) {
+        sum += m_slots[i].value.load(std::memory_order::relaxed);
+    }
+
+    return sum;
+}
+
+void ShardedCounter::reset() noexcept {
+    for (u32 i = 0; i <= m_slotMask; i++) {
+        m_slots[i].value.store(0, std::memory_order::relaxed);
+    }
+}
+
+}
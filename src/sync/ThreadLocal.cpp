@@ -0,0 +1,61 @@
+#include <asp/sync/ThreadLocal.hpp>
+#include <asp/sync/RawMutex.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace asp::detail {
+
+struct IndexAllocator {
+    RawMutex lock;
+    usize next = 0;
+    // min-heap of released indices
+    std::vector<usize> free;
+
+    usize acquire() {
+        lock.lock();
+
+        usize index;
+        if (!free.empty()) {
+            std::pop_heap(free.begin(), free.end(), std::greater<>{});
+            index = free.back();
+            free.pop_back();
+        } else {
+            index = next++;
+        }
+
+        lock.unlock();
+        return index;
+    }
+
+    void release(usize index) {
+        lock.lock();
+        free.push_back(index);
+        std::push_heap(free.begin(), free.end(), std::greater<>{});
+        lock.unlock();
+    }
+};
+
+// leaked, threads may exit after static destructors have run
+static IndexAllocator& allocator() {
+    static IndexAllocator* alloc = new IndexAllocator;
+    return *alloc;
+}
+
+struct ThreadIndex {
+    usize index;
+
+    ThreadIndex() : index(allocator().acquire()) {}
+
+    ~ThreadIndex() {
+        allocator().release(index);
+    }
+};
+
+usize threadLocalIndex() noexcept {
+    thread_local ThreadIndex index;
+    return index.index;
+}
+
+}
@@ -0,0 +1,33 @@
+#include <asp/sync/WaitGroup.hpp>
+#include <asp/sync/Futex.hpp>
+
+namespace asp {
+
+bool WaitGroup::waitUntil(const time::Instant& deadline) const noexcept {
+    u32 state = m_state.load(std::memory_order::acquire);
+
+    while ((state & COUNT_MASK) != 0) {
+        if (!(state & WAITING)) {
+            if (!m_state.compare_exchange_weak(state, state | WAITING, std::memory_order::acquire, std::memory_order::acquire)) {
+                continue;
+            }
+            state |= WAITING;
+        }
+
+        if (!futex::waitUntil(m_state, state, deadline)) {
+            return this->count() == 0;
+        }
+
+        state = m_state.load(std::memory_order::acquire);
+    }
+
+    return true;
+}
+
+void WaitGroup::wakeAll() noexcept {
+    // tasks may have been added again in the meantime, their waiters will set the bit again
+    m_state.fetch_and(~WAITING, std::memory_order::relaxed);
+    futex::wakeAll(m_state);
+}
+
+}
@@ -1,6 +1,21 @@
 #include <asp/thread/Thread.hpp>
 #include <asp/detail/config.hpp>
 
+unsigned int asp::cpuShardCount() noexcept {
+    static const unsigned int count = [] {
+        unsigned int cpus = std::thread::hardware_concurrency();
+        unsigned int count = 1;
+
+        while (count < cpus && count < 64) {
+            count <<= 1;
+        }
+
+        return count;
+    }();
+
+    return count;
+}
+
 #ifdef ASP_IS_WIN
 
 #include <Windows.h>
@@ -55,16 +70,36 @@ void asp::_setThreadName(const std::string& name) {
     obliterate(name);
 }
 
+unsigned int asp::currentCpu() noexcept {
+    return GetCurrentProcessorNumber();
+}
+
 #elif defined(__APPLE__)
 
+#include <atomic>
+
 void asp::_setThreadName(const std::string& name) {
     pthread_setname_np(name.c_str());
 }
 
+unsigned int asp::currentCpu() noexcept {
+    // no public api to query the cpu number, hand out indices round-robin instead
+    static std::atomic<unsigned int> counter{0};
+    thread_local unsigned int index = counter.fetch_add(1, std::memory_order::relaxed);
+    return index;
+}
+
 #else
 
+#include <sched.h>
+
 void asp::_setThreadName(const std::string& name) {
     pthread_setname_np(pthread_self(), name.c_str());
 }
 
+unsigned int asp::currentCpu() noexcept {
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : (unsigned int)cpu;
+}
+
 #endif
@@ -39,7 +39,7 @@ ThreadPool::ThreadPool(size_t tc) : _storage(std::make_shared<Storage>()) {
                 storage->onException(e);
             }
 
-            storage->remainingWork.fetch_sub(1, std::memory_order::acq_rel);
+            storage->remainingWork.done();
         });
 
         _storage->workers.emplace_back(std::move(thread));
@@ -79,7 +79,7 @@ ThreadPool::~ThreadPool() {
 void ThreadPool::pushTask(Task&& task) {
     this->_checkValid();
 
-    _storage->remainingWork.fetch_add(1, std::memory_order::relaxed);
+    _storage->remainingWork.add();
     _storage->taskQueue.push(std::move(task));
 }
 
@@ -102,19 +102,17 @@ bool ThreadPool::allDead() {
 void ThreadPool::join() {
     this->_checkValid();
 
-    _storage->notifyWaiter.store(true, std::memory_order::release);
-
     auto isDone = [&] {
         // if we are destructing, it's possible that all threads are dead now, just terminate
         if (m_destructing && this->allDead()) {
             return true;
         }
 
-        return _storage->remainingWork.load(std::memory_order::acquire) == 0;
+        return _storage->remainingWork.count() == 0;
     };
 
     while (!isDone()) {
-        if (_storage->waiterSem.try_acquire_for(std::chrono::milliseconds{25})) {
+        if (_storage->remainingWork.wait(time::Duration::fromMillis(25))) {
             break;
         }
     }
@@ -126,7 +124,7 @@ void ThreadPool::joinSpin() {
 
 bool ThreadPool::isDoingWork() {
     this->_checkValid();
-    return _storage->remainingWork.load(std::memory_order::acquire) > 0;
+    return _storage->remainingWork.count() > 0;
 }
 
 void ThreadPool::setExceptionFunction(CopyableFunction<void(const std::exception&)> f) {
@@ -199,4 +199,123 @@ TEST(CacheTest, TTL) {
     EXPECT_EQ(cache.get(2), nullptr);
     EXPECT_EQ(cache.get(3), nullptr);
     EXPECT_EQ(cache.size(), 0);
-}
\ No newline at end of file
+}
+
+TEST(DaryHeapTest, Basic) {
+    DaryHeap<int> heap;
+    for (int v : {5, 3, 8, 1, 9, 2, 7, 4, 6, 0}) {
+        heap.push(v);
+    }
+
+    EXPECT_EQ(heap.size(), 10);
+    EXPECT_EQ(heap.top(), 9);
+
+    for (int i = 9; i >= 0; i--) {
+        EXPECT_EQ(heap.pop(), i);
+    }
+
+    EXPECT_TRUE(heap.empty());
+}
+
+TEST(DaryHeapTest, MinHeap) {
+    DaryHeap<std::string, 8, std::greater<std::string>> heap;
+    heap.push("banana");
+    heap.push("cherry");
+    heap.push("apple");
+
+    EXPECT_EQ(heap.pop(), "apple");
+    EXPECT_EQ(heap.pop(), "banana");
+    EXPECT_EQ(heap.pop(), "cherry");
+}
+
+TEST(HashMapTest, Basic) {
+    HashMap<int, std::string> map;
+
+    for (int i = 0; i < 1000; i++) {
+        map.insert_or_assign(i, std::to_string(i));
+    }
+
+    EXPECT_EQ(map.size(), 1000);
+    EXPECT_EQ(*map.get(500), "500");
+    EXPECT_EQ(map.get(1000), nullptr);
+
+    for (int i = 0; i < 1000; i += 2) {
+        EXPECT_TRUE(map.erase(i));
+    }
+
+    EXPECT_EQ(map.size(), 500);
+    EXPECT_FALSE(map.contains(2));
+    EXPECT_TRUE(map.contains(3));
+
+    size_t count = 0;
+    for (auto& [key, value] : map) {
+        EXPECT_EQ(key % 2, 1);
+        EXPECT_EQ(value, std::to_string(key));
+        count++;
+    }
+    EXPECT_EQ(count, 500);
+
+    // erasing while iterating
+    for (auto it = map.begin(); it != map.end();) {
+        it = it->first < 500 ? map.erase(it) : std::next(it);
+    }
+    EXPECT_EQ(map.size(), 250);
+
+    map[7] = "seven";
+    EXPECT_EQ(map[7], "seven");
+    EXPECT_FALSE(map.try_emplace(7, "other").second);
+}
+
+TEST(HashMapTest, HeterogeneousLookup) {
+    HashMap<std::string, int> map{{"one", 1}, {"two", 2}};
+
+    std::string_view key = "two";
+    EXPECT_EQ(*map.get(key), 2);
+    EXPECT_EQ(map.find("one")->second, 1);
+    EXPECT_TRUE(map.erase(std::string_view{"one"}));
+    EXPECT_FALSE(map.contains("one"));
+
+    HashSet<std::string> set{"a", "b"};
+    EXPECT_TRUE(set.contains(std::string_view{"a"}));
+    EXPECT_FALSE(set.insert("a").second);
+    EXPECT_EQ(set.size(), 2);
+}
+
+TEST(HashMapTest, ReserveShrink) {
+    HashMap<int, int> map;
+    map.reserve(100);
+
+    size_t capacity = map.capacity();
+    EXPECT_GE(capacity, 100);
+
+    for (int i = 0; i < 100; i++) {
+        map[i] = i;
+    }
+    EXPECT_EQ(map.capacity(), capacity);
+
+    for (int i = 0; i < 95; i++) {
+        map.erase(i);
+    }
+
+    map.shrink();
+    EXPECT_LT(map.capacity(), capacity);
+    EXPECT_EQ(map.size(), 5);
+    EXPECT_EQ(*map.get(99), 99);
+
+    map.clear();
+    map.shrink();
+    EXPECT_EQ(map.capacity(), 0);
+    EXPECT_EQ(map.get(99), nullptr);
+}
+
+TEST(HashMapTest, CacheStorage) {
+    Cache<std::string, int, HashMap> cache;
+    cache.setMaxEntries(2);
+
+    cache.insert("a", 1);
+    cache.insert("b", 2);
+    cache.insert("c", 3);
+
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(*cache.get("c"), 3);
+}
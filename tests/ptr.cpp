@@ -1,5 +1,8 @@
 #include <asp/ptr.hpp>
+#include <asp/ptr/BoxedString.hpp>
+#include <asp/ptr/Symbol.hpp>
 #include <gtest/gtest.h>
+#include <span>
 #include <thread>
 
 using namespace asp;
@@ -132,3 +135,372 @@ TEST(PtrSwapTest, Rcu) {
     /// should be guaranteed to have 32*128 pushes, since rcu is atomic
     EXPECT_EQ(swap.load()->size(), 4 * 64);
 }
+
+TEST(PtrSwapTest, Guard) {
+    PtrSwap<std::string> swap;
+    EXPECT_FALSE(swap.loadGuard());
+
+    auto ptr1 = make_shared<std::string>("first");
+    swap.store(ptr1);
+
+    {
+        auto guard = swap.loadGuard();
+        EXPECT_EQ(*guard, "first");
+        // borrowed, the refcount is untouched
+        EXPECT_EQ(ptr1.strongCount(), 2);
+
+        // replacing the value pays the guard's debt, so it stays valid
+        swap.store(make_shared<std::string>("second"));
+        EXPECT_EQ(ptr1.strongCount(), 2);
+        EXPECT_EQ(*guard, "first");
+    }
+
+    EXPECT_EQ(ptr1.strongCount(), 1);
+
+    // more guards than hazard slots fall back to real references
+    std::vector<PtrSwap<std::string>::Guard> guards;
+    for (size_t i = 0; i < 16; i++) {
+        guards.push_back(swap.loadGuard());
+    }
+
+    auto shared = guards.back().toShared();
+    guards.clear();
+    EXPECT_EQ(*shared, "second");
+    EXPECT_EQ(shared.strongCount(), 2);
+}
+
+TEST(PtrSwapTest, ConcurrentLoads) {
+    PtrSwap<std::vector<int>> swap{make_shared<std::vector<int>>(100, 0)};
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+
+    for (size_t i = 0; i < 4; i++) {
+        readers.emplace_back([&] {
+            while (!done.load(std::memory_order::relaxed)) {
+                auto guard = swap.loadGuard();
+                EXPECT_EQ(guard->size(), 100);
+
+                auto ptr = swap.load();
+                EXPECT_EQ(ptr->front(), ptr->back());
+            }
+        });
+    }
+
+    for (int i = 1; i <= 2000; i++) {
+        swap.store(make_shared<std::vector<int>>(100, i));
+    }
+
+    done = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    EXPECT_EQ(swap.load().strongCount(), 2);
+}
+
+TEST(RcTest, Basic) {
+    auto rc1 = make_rc<std::string>("local");
+    EXPECT_EQ(rc1.strongCount(), 1);
+    EXPECT_EQ(rc1.weakCount(), 1);
+
+    Weak<std::string> weak = rc1;
+    EXPECT_EQ(rc1.weakCount(), 2);
+
+    {
+        auto rc2 = rc1;
+        EXPECT_EQ(rc1.strongCount(), 2);
+        EXPECT_EQ(*rc2, "local");
+    }
+
+    // not unique while a weak reference exists
+    auto notShared = std::move(rc1).intoShared();
+    EXPECT_FALSE(notShared);
+    EXPECT_TRUE(rc1);
+
+    EXPECT_EQ(*weak.upgrade(), "local");
+    weak = nullptr;
+
+    auto shared = std::move(rc1).intoShared();
+    EXPECT_FALSE(rc1);
+    EXPECT_EQ(*shared, "local");
+    EXPECT_EQ(shared.strongCount(), 1);
+}
+
+TEST(RcTest, WeakExpires) {
+    Weak<std::vector<int>> weak;
+
+    {
+        auto rc = make_rc<std::vector<int>>(std::vector<int>{1, 2, 3});
+        weak = rc;
+        EXPECT_FALSE(weak.expired());
+    }
+
+    EXPECT_TRUE(weak.expired());
+    EXPECT_FALSE(weak.upgrade());
+}
+
+struct Node : RefCounted<Node> {
+    int value;
+    IntrusivePtr<Node> next;
+
+    Node(int value, IntrusivePtr<Node> next = nullptr) : value(value), next(std::move(next)) {}
+};
+
+struct LocalNode : RefCounted<LocalNode, refcount::Local> {
+    static inline int alive = 0;
+
+    LocalNode() { alive++; }
+    ~LocalNode() { alive--; }
+};
+
+TEST(IntrusivePtrTest, Basic) {
+    static_assert(sizeof(IntrusivePtr<Node>) == sizeof(void*));
+
+    auto tail = makeIntrusive<Node>(2);
+    auto head = makeIntrusive<Node>(1, tail);
+    EXPECT_EQ(tail.refCount(), 2);
+    EXPECT_EQ(head->next->value, 2);
+
+    // a raw pointer can be turned back into a new reference
+    IntrusivePtr<Node> again{tail.get()};
+    EXPECT_EQ(tail.refCount(), 3);
+
+    head.reset();
+    EXPECT_EQ(tail.refCount(), 2);
+
+    {
+        auto local = makeIntrusive<LocalNode>();
+        auto copy = local;
+        EXPECT_EQ(copy.refCount(), 2);
+        EXPECT_EQ(LocalNode::alive, 1);
+    }
+
+    EXPECT_EQ(LocalNode::alive, 0);
+}
+
+TEST(IntrusivePtrTest, PtrSwap) {
+    PtrSwap<Node, IntrusivePtr<Node>> swap{makeIntrusive<Node>(1)};
+
+    auto guard = swap.loadGuard();
+    EXPECT_EQ(guard->value, 1);
+
+    auto old = swap.swap(makeIntrusive<Node>(2));
+    EXPECT_EQ(old->value, 1);
+    // the guard's debt was paid by the swap
+    EXPECT_EQ(old.refCount(), 2);
+
+    EXPECT_EQ(swap.load()->value, 2);
+    EXPECT_EQ(swap.load().refCount(), 2);
+
+    auto updated = swap.rcu([](const IntrusivePtr<Node>& cur) { return makeIntrusive<Node>(cur->value + 1); });
+    EXPECT_EQ(updated->value, 3);
+}
+
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    size_t* allocs;
+    size_t* frees;
+
+    CountingAllocator(size_t* allocs, size_t* frees) : allocs(allocs), frees(frees) {}
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) : allocs(other.allocs), frees(other.frees) {}
+
+    T* allocate(size_t n) {
+        (*allocs)++;
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        (*frees)++;
+        std::allocator<T>{}.deallocate(ptr, n);
+    }
+};
+
+TEST(SharedPtrTest, AllocateShared) {
+    size_t allocs = 0, frees = 0;
+
+    {
+        auto ptr = allocateShared<std::string>(CountingAllocator<std::string>{&allocs, &frees}, "allocated");
+        WeakPtr<std::string> weak = ptr;
+        EXPECT_EQ(*ptr, "allocated");
+        EXPECT_EQ(allocs, 1);
+
+        ptr.reset();
+        // the weak reference keeps the block alive
+        EXPECT_EQ(frees, 0);
+    }
+
+    EXPECT_EQ(frees, 1);
+}
+
+TEST(SharedPtrTest, Pooled) {
+    void* first;
+
+    {
+        auto ptr = makeSharedPooled<std::vector<int>>(3, 7);
+        EXPECT_EQ(ptr->size(), 3);
+        first = ptr.get();
+    }
+
+    // freed blocks are reused by the same thread
+    auto ptr = makeSharedPooled<std::vector<int>>(1, 1);
+    EXPECT_EQ((void*)ptr.get(), first);
+}
+
+TEST(SharedPtrTest, ArrayFromRange) {
+    std::vector<std::string> src{"a", "bb", "ccc"};
+    auto arr = makeSharedFromRange<std::string[]>(std::span{src});
+    ASSERT_EQ(arr.size(), 3);
+    EXPECT_EQ(arr.get()[2], "ccc");
+
+    auto buf = makeSharedForOverwrite<char[]>(4);
+    std::copy_n("abc", 4, buf.get());
+    EXPECT_STREQ(buf.get(), "abc");
+
+    static int drops = 0;
+
+    struct Throwing {
+        Throwing(int x) {
+            if (x == 2) throw 0;
+        }
+
+        ~Throwing() { drops++; }
+    };
+
+    // already constructed elements are destroyed if one of them throws
+    int values[] = {1, 2, 3};
+    EXPECT_THROW(makeSharedFromRange<Throwing[]>(values), int);
+    EXPECT_EQ(drops, 1);
+}
+
+TEST(SharedPtrTest, Biased) {
+    static std::atomic<int> drops{0};
+
+    struct Tracked {
+        ~Tracked() { drops++; }
+    };
+
+    auto ptr = makeSharedBiased<Tracked>();
+    WeakPtr<Tracked> weak = ptr;
+
+    {
+        auto copy = ptr;
+        EXPECT_EQ(ptr.strongCount(), 2);
+    }
+
+    // references that cross threads have their counts merged by the owner
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([copy = ptr]() mutable {
+            for (int j = 0; j < 1000; j++) {
+                auto other = copy;
+            }
+        });
+    }
+
+    for (auto& t : threads) t.join();
+
+    EXPECT_EQ(ptr.strongCount(), 1);
+    EXPECT_EQ(drops, 0);
+
+    ptr.reset();
+    mergeBiasedRefcounts();
+
+    EXPECT_EQ(drops, 1);
+    EXPECT_TRUE(weak.expired());
+    EXPECT_FALSE(weak.upgrade());
+
+    // an object that outlives its owner thread
+    SharedPtr<Tracked> orphan;
+    std::thread([&] { orphan = makeSharedBiased<Tracked>(); }).join();
+
+    EXPECT_EQ(orphan.strongCount(), 1);
+    orphan.reset();
+    EXPECT_EQ(drops, 2);
+}
+
+TEST(SymbolTest, Interning) {
+    Symbol a{"symbol-test"};
+    auto b = Symbol::intern(std::string("symbol-") + "test");
+    Symbol c{"symbol-other"};
+
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(a.view().data(), b.view().data());
+    EXPECT_EQ(a.hash(), std::hash<std::string_view>{}("symbol-test"));
+    EXPECT_STREQ(c.c_str(), "symbol-other");
+
+    EXPECT_EQ(Symbol{""}, Symbol{});
+    EXPECT_TRUE(Symbol::find("symbol-other").has_value());
+    EXPECT_FALSE(Symbol::find("symbol-never-interned").has_value());
+}
+
+TEST(SymbolTest, CollectUnused) {
+    {
+        Symbol sym{"symbol-collected"};
+        Symbol::collectUnused();
+        EXPECT_TRUE(Symbol::find("symbol-collected").has_value());
+    }
+
+    EXPECT_TRUE(Symbol::find("symbol-collected").has_value());
+    EXPECT_GE(Symbol::collectUnused(), 1);
+    EXPECT_FALSE(Symbol::find("symbol-collected").has_value());
+
+    // interning it again creates a new entry
+    Symbol again{"symbol-collected"};
+    EXPECT_EQ(again, "symbol-collected");
+}
+
+TEST(SymbolTest, Concurrent) {
+    std::vector<std::thread> threads;
+    std::vector<std::vector<Symbol>> results(4);
+
+    for (size_t t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 2000; i++) {
+                results[t].emplace_back(fmt::format("sym-{}", i));
+
+                if (i % 500 == 0) Symbol::collectUnused();
+            }
+        });
+    }
+
+    for (auto& t : threads) t.join();
+
+    for (int i = 0; i < 2000; i++) {
+        EXPECT_EQ(results[0][i], results[3][i]);
+        EXPECT_EQ(results[1][i], fmt::format("sym-{}", i));
+    }
+}
+
+TEST(BoxedStringTest, Inline) {
+    BoxedString small{"short key"};
+    BoxedString large{"a string that does not fit inline"};
+
+    EXPECT_TRUE(small.isInline());
+    EXPECT_FALSE(large.isInline());
+    EXPECT_EQ(small, "short key");
+    EXPECT_STREQ(large.c_str(), "a string that does not fit inline");
+
+    // copies of heap strings share the buffer
+    auto copy = large;
+    EXPECT_EQ(copy.c_str(), large.c_str());
+
+    auto moved = std::move(small);
+    EXPECT_EQ(moved, "short key");
+    EXPECT_TRUE(small.empty());
+
+    auto formatted = BoxedString::format("{}-{}", "key", 42);
+    EXPECT_TRUE(formatted.isInline());
+    EXPECT_EQ(formatted, "key-42");
+
+    auto unique = UniqueBoxedString::format("{:>30}", "right");
+    EXPECT_FALSE(unique.isInline());
+    EXPECT_EQ(unique.clone().view(), unique.view());
+
+    EXPECT_EQ(std::hash<BoxedString>{}(copy), std::hash<std::string_view>{}(copy.view()));
+    EXPECT_EQ(moved.hash(), std::hash<std::string_view>{}("short key"));
+}
@@ -0,0 +1,1039 @@
+#include <asp/sync.hpp>
+#include <asp/thread.hpp>
+#include <asp/time.hpp>
+#include <gtest/gtest.h>
+#include <deque>
+#include <thread>
+
+using namespace asp;
+
+TEST(WatchChannelTest, Basic) {
+    WatchChannel<int> ch{asp::make_shared<int>(1)};
+    auto rx = ch.subscribe();
+
+    EXPECT_FALSE(rx.changed());
+    EXPECT_EQ(*rx.borrow(), 1);
+
+    ch.send(2);
+    EXPECT_TRUE(rx.changed());
+    EXPECT_EQ(*rx.borrowAndUpdate(), 2);
+    EXPECT_FALSE(rx.changed());
+
+    auto old = ch.replace(asp::make_shared<int>(3));
+    EXPECT_EQ(*old, 2);
+    EXPECT_EQ(ch.version(), 2);
+}
+
+TEST(WatchChannelTest, WaitForChange) {
+    WatchChannel<int> ch;
+    auto rx = ch.subscribe();
+
+    EXPECT_FALSE(rx.waitForChange(Duration::fromMillis(5)));
+
+    std::thread sender([&] {
+        for (int i = 1; i <= 100; i++) {
+            ch.send(i);
+        }
+    });
+
+    int last = 0;
+    while (last != 100) {
+        // a value can be returned twice if it was sent in between loading the version and the value
+        auto val = rx.waitForChange();
+        EXPECT_GE(*val, last);
+        last = *val;
+    }
+
+    sender.join();
+}
+
+TEST(SegQueueTest, Basic) {
+    SegQueue<std::string> q;
+    EXPECT_TRUE(q.empty());
+    EXPECT_FALSE(q.pop());
+
+    for (int i = 0; i < 100; i++) {
+        q.push(std::to_string(i));
+    }
+
+    EXPECT_EQ(q.size(), 100);
+
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(q.pop(), std::to_string(i));
+    }
+
+    EXPECT_TRUE(q.empty());
+
+    // leave some elements for the destructor
+    q.push("leftover");
+    q.push("leftover 2");
+}
+
+TEST(SegQueueTest, Concurrent) {
+    constexpr int PER_THREAD = 10000;
+    SegQueue<int> q;
+    std::atomic<long long> sum{0};
+    std::atomic<int> popped{0};
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            for (int i = 1; i <= PER_THREAD; i++) {
+                q.push(i);
+            }
+        });
+
+        threads.emplace_back([&] {
+            while (popped.load() < 4 * PER_THREAD) {
+                if (auto v = q.pop()) {
+                    sum += *v;
+                    popped++;
+                }
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(sum.load(), 4ll * PER_THREAD * (PER_THREAD + 1) / 2);
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(ChannelTest, LockFree) {
+    Channel<int, channel::LockFree> ch;
+    EXPECT_FALSE(ch.popTimeout(Duration::fromMillis(5)));
+
+    std::thread sender([&] {
+        for (int i = 0; i < 1000; i++) {
+            ch.push(i);
+        }
+    });
+
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(ch.pop(), i);
+    }
+
+    sender.join();
+    EXPECT_TRUE(ch.empty());
+    EXPECT_THROW(ch.popNow(), std::runtime_error);
+}
+
+TEST(PriorityChannelTest, Basic) {
+    PriorityChannel<int> ch;
+    ch.pushAll(std::vector<int>{3, 1, 4, 1, 5, 9, 2, 6});
+    ch.push(7);
+
+    EXPECT_EQ(ch.size(), 9);
+    EXPECT_EQ(ch.pop(), 9);
+    EXPECT_EQ(ch.popTimeout(Duration::fromMillis(1)), 7);
+
+    auto rest = ch.drain();
+    EXPECT_EQ(rest, (std::vector<int>{6, 5, 4, 3, 2, 1, 1}));
+    EXPECT_FALSE(ch.tryPop());
+}
+
+TEST(DeadlineChannelTest, Ordering) {
+    DeadlineChannel<std::string> ch;
+    auto now = Instant::now();
+
+    ch.push("late", now + Duration::fromMillis(30));
+    ch.push("first", now);
+    ch.push("second", now);
+    ch.pushAfter("middle", Duration::fromMillis(15));
+
+    EXPECT_EQ(ch.tryPop(), "first");
+    EXPECT_EQ(ch.pop(), "second");
+    EXPECT_FALSE(ch.tryPop());
+
+    EXPECT_EQ(ch.pop(), "middle");
+    EXPECT_GE(now.elapsed(), Duration::fromMillis(15));
+
+    EXPECT_FALSE(ch.popTimeout(Duration::fromMillis(1)));
+    EXPECT_THROW(ch.popNow(), std::runtime_error);
+
+    ch.waitForMessages(Duration::fromSecs(5));
+    EXPECT_GE(now.elapsed(), Duration::fromMillis(30));
+    EXPECT_EQ(ch.popNow(), "late");
+    EXPECT_TRUE(ch.empty());
+}
+
+TEST(DeadlineChannelTest, EarlierPushWakesReceiver) {
+    DeadlineChannel<int> ch;
+    ch.pushAfter(1, Duration::fromSecs(10));
+
+    std::thread sender([&] {
+        asp::sleep(Duration::fromMillis(5));
+        ch.pushAfter(2, Duration::fromMillis(5));
+    });
+
+    auto start = Instant::now();
+    EXPECT_EQ(ch.pop(), 2);
+    EXPECT_LT(start.elapsed(), Duration::fromSecs(5));
+
+    sender.join();
+}
+
+TEST(MutexTest, Basic) {
+    static_assert(sizeof(Mutex<>) == 1);
+
+    Mutex<std::vector<int>> mtx;
+    {
+        auto guard = mtx.lock();
+        guard->push_back(1);
+        guard.unlock();
+        guard.relock();
+        EXPECT_EQ(guard->size(), 1);
+    }
+
+    EXPECT_EQ(mtx.lock()->size(), 1);
+}
+
+TEST(MutexTest, Contended) {
+    Mutex<size_t> mtx{0};
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 8; i++) {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < 20000; j++) {
+                auto guard = mtx.lock();
+                *guard = *guard + 1;
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(*mtx.lock(), 8 * 20000);
+}
+
+TEST(MutexTest, Recursive) {
+    Mutex<int, true> mtx{1};
+    auto g1 = mtx.lock();
+    auto g2 = mtx.lock();
+    EXPECT_EQ(*g2, 1);
+}
+
+template <typename Lock>
+static void rwLockStress(Lock& lock) {
+    std::vector<std::thread> threads;
+    std::atomic<bool> failed{false};
+
+    for (size_t i = 0; i < 2; i++) {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < 2000; j++) {
+                auto guard = lock.write();
+                guard->first++;
+                guard->second++;
+            }
+        });
+    }
+
+    for (size_t i = 0; i < 6; i++) {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < 5000; j++) {
+                auto guard = lock.read();
+                if (guard->first != guard->second) failed = true;
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_FALSE(failed.load());
+    EXPECT_EQ(lock.read()->first, 4000);
+}
+
+TEST(RwLockTest, Basic) {
+    RwLock<std::string> lock{"hello"};
+
+    {
+        auto r1 = lock.read();
+        auto r2 = lock.read();
+        EXPECT_EQ(*r1, "hello");
+        EXPECT_EQ(r2->size(), 5);
+    }
+
+    {
+        auto w = lock.write();
+        *w = "world";
+    }
+
+    EXPECT_EQ(*lock.read(), "world");
+}
+
+TEST(RwLockTest, Contended) {
+    RwLock<std::pair<size_t, size_t>> lock;
+    rwLockStress(lock);
+}
+
+TEST(RwLockTest, Sharded) {
+    ShardedRwLock<std::pair<size_t, size_t>> lock;
+    rwLockStress(lock);
+
+    RawShardedRwLock raw;
+    auto token = raw.lockShared();
+    EXPECT_FALSE(raw.tryLock());
+    raw.unlockShared(token);
+    EXPECT_TRUE(raw.tryLock());
+    EXPECT_FALSE(raw.tryLockShared());
+    raw.unlock();
+
+    auto tried = raw.tryLockShared();
+    ASSERT_TRUE(tried);
+    EXPECT_FALSE(raw.tryLock());
+    raw.unlockShared(*tried);
+    EXPECT_TRUE(raw.tryLock());
+    raw.unlock();
+}
+
+TEST(SeqLockTest, Basic) {
+    struct Pos {
+        float x, y, z;
+    };
+
+    SeqLock<Pos> lock{Pos{1.f, 2.f, 3.f}};
+    EXPECT_EQ(lock.load().y, 2.f);
+    EXPECT_EQ(lock.version(), 0);
+
+    lock.store(Pos{4.f, 5.f, 6.f});
+    lock.update([](Pos& p) { p.x += 1.f; });
+
+    auto pos = lock.tryLoad();
+    ASSERT_TRUE(pos);
+    EXPECT_EQ(pos->x, 5.f);
+    EXPECT_EQ(pos->z, 6.f);
+    EXPECT_EQ(lock.version(), 4);
+}
+
+TEST(SeqLockTest, NoTornReads) {
+    struct Pair {
+        u64 a, b, c;
+    };
+
+    SeqLock<Pair> lock;
+    std::atomic<bool> done{false};
+    std::atomic<bool> torn{false};
+
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < 4; i++) {
+        readers.emplace_back([&] {
+            while (!done.load(std::memory_order::relaxed)) {
+                auto p = lock.load();
+                if (p.a != p.b || p.b != p.c) torn = true;
+            }
+        });
+    }
+
+    for (u64 i = 1; i <= 100000; i++) {
+        lock.store(Pair{i, i, i});
+    }
+
+    done = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    EXPECT_FALSE(torn.load());
+    EXPECT_EQ(lock.load().a, 100000);
+}
+
+template <typename Lock>
+static void spinLockStress() {
+    Lock lock{0};
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < 5000; j++) {
+                auto guard = lock.lock();
+                *guard = *guard + 1;
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(*lock.lock(), 4 * 5000);
+}
+
+TEST(SpinLockTest, Contended) {
+    spinLockStress<SpinLock<size_t>>();
+}
+
+TEST(SpinLockTest, Ticket) {
+    static_assert(alignof(TicketSpinLock<>) == ASP_CACHE_LINE_SIZE);
+    spinLockStress<TicketSpinLock<size_t>>();
+
+    TicketSpinLock<> lock;
+    auto guard = lock.lock();
+    guard.unlock();
+    guard.relock();
+}
+
+TEST(SpinLockTest, Mcs) {
+    spinLockStress<McsSpinLock<size_t>>();
+}
+
+TEST(NotifyTest, StoresPermit) {
+    static_assert(sizeof(Notify) == 1);
+
+    Notify notify;
+
+    // no waiters yet, the permit is stored and consumed by the next wait
+    notify.notifyOne();
+    notify.notifyOne();
+    EXPECT_TRUE(notify.wait(Duration::fromMillis(1)));
+    EXPECT_FALSE(notify.wait(Duration::fromMillis(1)));
+
+    // notifyAll does not store a permit
+    notify.notifyAll();
+    EXPECT_FALSE(notify.wait(Duration::zero()));
+}
+
+TEST(NotifyTest, Timeout) {
+    Notify notify;
+
+    auto start = Instant::now();
+    EXPECT_FALSE(notify.wait(Duration::fromMillis(20)));
+    EXPECT_GE(start.elapsed(), Duration::fromMillis(20));
+
+    EXPECT_FALSE(notify.waitUntil(Instant::now() + Duration::fromMillis(5)));
+}
+
+TEST(NotifyTest, WakesWaiters) {
+    Notify notify;
+    std::atomic<size_t> woken{0};
+    std::atomic<bool> ready{false};
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            notify.wait(Duration::zero(), [&] { return ready.load(); });
+            woken++;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ready = true;
+    notify.notifyAll();
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(woken, 4);
+
+    // every notifyOne wakes exactly one plain waiter
+    std::thread waiter([&] {
+        notify.wait();
+        notify.wait();
+        woken++;
+    });
+
+    notify.notifyOne();
+    while (woken == 4) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        notify.notifyOne();
+    }
+
+    waiter.join();
+}
+
+TEST(NotifyTest, Pollable) {
+    PollableNotify notify;
+
+    EXPECT_FALSE(notify.consume());
+    EXPECT_FALSE(notify.wait(Duration::fromMillis(1)));
+
+    notify.notify();
+    notify.notify();
+    EXPECT_TRUE(notify.wait(Duration::fromMillis(1)));
+    EXPECT_FALSE(notify.consume());
+
+    std::thread t([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        notify.notify();
+    });
+
+    notify.wait();
+    t.join();
+}
+
+TEST(SemaphoreTest, Basic) {
+    Semaphore sem{2};
+
+    EXPECT_TRUE(sem.tryAcquire());
+    sem.acquire();
+    EXPECT_FALSE(sem.tryAcquire());
+    EXPECT_FALSE(sem.acquire(Duration::fromMillis(5)));
+
+    std::thread t([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        sem.release(2);
+    });
+
+    sem.acquire();
+    EXPECT_TRUE(sem.acquire(Duration::fromSecs(5)));
+    t.join();
+
+    EXPECT_EQ(sem.available(), 0);
+}
+
+TEST(SemaphoreTest, LimitsConcurrency) {
+    Semaphore sem{2};
+    std::atomic<u32> inside{0}, maxInside{0};
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < 500; j++) {
+                sem.acquire();
+
+                u32 now = ++inside;
+                u32 prev = maxInside.load();
+                while (now > prev && !maxInside.compare_exchange_weak(prev, now)) {}
+
+                --inside;
+                sem.release();
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_LE(maxInside, 2);
+    EXPECT_EQ(sem.available(), 2);
+}
+
+TEST(WaitGroupTest, Basic) {
+    WaitGroup wg;
+    EXPECT_TRUE(wg.wait(Duration::zero()));
+
+    std::atomic<size_t> finished{0};
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 4; i++) {
+        wg.add();
+        threads.emplace_back([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            finished++;
+            wg.done();
+        });
+    }
+
+    wg.wait();
+    EXPECT_EQ(finished, 4);
+    EXPECT_EQ(wg.count(), 0);
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    // reusable after reaching zero
+    wg.add();
+    EXPECT_FALSE(wg.wait(Duration::fromMillis(2)));
+    wg.done();
+    EXPECT_TRUE(wg.wait(Duration::fromMillis(2)));
+}
+
+TEST(LatchTest, Basic) {
+    Latch latch{3};
+    EXPECT_FALSE(latch.tryWait());
+
+    std::thread t([&] {
+        latch.countDown(2);
+        latch.arriveAndWait();
+    });
+
+    latch.wait();
+    EXPECT_TRUE(latch.tryWait());
+    t.join();
+}
+
+TEST(BarrierTest, Phases) {
+    constexpr u32 THREADS = 4;
+    constexpr size_t PHASES = 100;
+
+    size_t completions = 0;
+    Barrier barrier{THREADS, [&] { completions++; }};
+
+    std::atomic<size_t> leaders{0};
+    std::atomic<size_t> counter{0};
+    std::vector<std::thread> threads;
+
+    for (u32 i = 0; i < THREADS; i++) {
+        threads.emplace_back([&] {
+            for (size_t p = 0; p < PHASES; p++) {
+                counter++;
+
+                if (barrier.arriveAndWait()) {
+                    leaders++;
+                }
+
+                // everyone has incremented the counter for this phase before anyone leaves the barrier
+                EXPECT_GE(counter.load(), (p + 1) * THREADS);
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(completions, PHASES);
+    EXPECT_EQ(leaders, PHASES);
+}
+
+TEST(BarrierTest, Timeout) {
+    Barrier barrier{2};
+
+    auto token = barrier.arrive();
+    EXPECT_FALSE(barrier.wait(token, Duration::fromMillis(5)));
+
+    std::thread t([&] {
+        barrier.arriveAndWait();
+    });
+
+    EXPECT_TRUE(barrier.wait(token, Duration::fromSecs(5)));
+    t.join();
+}
+
+#ifdef ASP_LOCK_PROFILING
+TEST(LockProfilerTest, RecordsCallSites) {
+    lockprof::reset();
+
+    Mutex<int> mtx{0};
+    SpinLock<int> spin{0};
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < 1000; j++) {
+                *mtx.lock() += 1;
+                *spin.lock() += 1;
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    u64 total = 0;
+    for (auto& site : lockprof::snapshot()) {
+        if (std::string_view{site.location.file_name()}.ends_with("sync.cpp")) {
+            EXPECT_EQ(site.acquisitions, 4000);
+            EXPECT_LE(site.contended, site.acquisitions);
+            total += site.acquisitions;
+        }
+    }
+
+    EXPECT_EQ(total, 8000);
+    EXPECT_FALSE(lockprof::dump().empty());
+}
+#endif
+
+TEST(EpochTest, DefersWhilePinned) {
+    static std::atomic<size_t> destroyed{0};
+    destroyed = 0;
+
+    struct Tracked {
+        ~Tracked() { destroyed++; }
+    };
+
+    std::atomic<bool> pinned{false}, release{false};
+    std::thread reader([&] {
+        auto guard = epoch::pin();
+        pinned = true;
+
+        while (!release) {
+            std::this_thread::yield();
+        }
+    });
+
+    while (!pinned) {
+        std::this_thread::yield();
+    }
+
+    {
+        auto guard = epoch::pin();
+        EXPECT_TRUE(epoch::isPinned());
+        guard.defer(new Tracked);
+    }
+
+    EXPECT_FALSE(epoch::isPinned());
+
+    // the reader is pinned, so the epoch can advance at most once and nothing gets freed
+    for (size_t i = 0; i < 10; i++) {
+        epoch::pin().flush();
+    }
+
+    EXPECT_EQ(destroyed, 0);
+
+    release = true;
+    reader.join();
+
+    for (size_t i = 0; i < 10 && destroyed == 0; i++) {
+        epoch::pin().flush();
+    }
+
+    EXPECT_EQ(destroyed, 1);
+}
+
+TEST(EpochTest, ConcurrentSwap) {
+    struct Node {
+        size_t value;
+        size_t check;
+    };
+
+    std::atomic<Node*> current{new Node{0, ~size_t(0)}};
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 3; i++) {
+        threads.emplace_back([&] {
+            while (!stop) {
+                auto guard = epoch::pin();
+                auto node = current.load(std::memory_order::acquire);
+                EXPECT_EQ(node->value, ~node->check);
+            }
+        });
+    }
+
+    Thread<> writer([&](auto& stopToken) {
+        for (size_t i = 1; i <= 5000; i++) {
+            auto guard = epoch::pin();
+            auto old = current.exchange(new Node{i, ~i}, std::memory_order::acq_rel);
+            guard.defer(old);
+        }
+
+        stopToken.stop();
+    });
+    writer.start();
+    writer.join();
+
+    stop = true;
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    delete current.load();
+}
+
+TEST(OnceCellTest, Basic) {
+    OnceCell<std::string> cell;
+    EXPECT_EQ(cell.get(), nullptr);
+
+    EXPECT_EQ(cell.getOrInit([] { return std::string("hello"); }), "hello");
+    EXPECT_EQ(cell.getOrInit([] { return std::string("world"); }), "hello");
+    EXPECT_FALSE(cell.set("again"));
+    EXPECT_EQ(*cell.get(), "hello");
+
+    OnceCell<int> failing;
+    EXPECT_THROW(failing.getOrInit([]() -> int { throw std::runtime_error("fail"); }), std::runtime_error);
+    EXPECT_FALSE(failing.isInitialized());
+
+    auto res = failing.getOrTryInit([]() -> Result<int, std::string> { return Err(std::string("nope")); });
+    EXPECT_TRUE(res.isErr());
+    EXPECT_FALSE(failing.isInitialized());
+
+    auto ok = failing.getOrTryInit([]() -> Result<int, std::string> { return Ok(5); });
+    ASSERT_TRUE(ok.isOk());
+    EXPECT_EQ(*std::move(ok).unwrap(), 5);
+}
+
+TEST(OnceCellTest, ConcurrentInit) {
+    OnceCell<int> cell;
+    std::atomic<size_t> calls{0};
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 8; i++) {
+        threads.emplace_back([&] {
+            int value = cell.getOrInit([&] {
+                calls++;
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                return 42;
+            });
+            EXPECT_EQ(value, 42);
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(LazyLockTest, Basic) {
+    size_t calls = 0;
+    LazyLock lazy = [&] {
+        calls++;
+        return std::vector<int>{1, 2, 3};
+    };
+
+    EXPECT_FALSE(lazy.isInitialized());
+    EXPECT_EQ(lazy->size(), 3);
+    EXPECT_EQ((*lazy)[1], 2);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(ParkingLotTest, UnparkToken) {
+    int key = 0;
+    std::atomic<bool> parked{false};
+    parking::ParkResult result{};
+
+    std::thread waiter([&] {
+        result = parking::park(&key, [&] {
+            parked = true;
+            return true;
+        });
+    });
+
+    while (!parked) {
+        std::this_thread::yield();
+    }
+
+    // validate runs with the bucket locked and the waiter is enqueued before it is released, so unparkOne always finds it
+    auto unparked = parking::unparkOne(&key, [](parking::UnparkResult) -> parking::UnparkToken { return 42; });
+
+    waiter.join();
+
+    EXPECT_EQ(unparked.unparkedThreads, 1);
+    EXPECT_FALSE(unparked.haveMoreThreads);
+    EXPECT_EQ(result.kind, parking::ParkResult::Unparked);
+    EXPECT_EQ(result.token, 42);
+    EXPECT_EQ(parking::unparkAll(&key), 0);
+}
+
+TEST(ParkingLotTest, InvalidAndTimeout) {
+    int key = 0;
+
+    auto result = parking::park(&key, [] { return false; });
+    EXPECT_EQ(result.kind, parking::ParkResult::Invalid);
+
+    bool wasLast = false;
+    result = parking::park(&key, [] { return true; }, [] {}, [&](const void*, bool last) { wasLast = last; }, Instant::now() + Duration::fromMillis(5));
+    EXPECT_EQ(result.kind, parking::ParkResult::TimedOut);
+    EXPECT_TRUE(wasLast);
+}
+
+TEST(ShardedCounterTest, Concurrent) {
+    ShardedCounter counter;
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < 10000; j++) {
+                counter.add();
+            }
+            counter.sub(500);
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(counter.load(), 4 * 9500);
+
+    counter.reset();
+    EXPECT_EQ(counter.load(), 0);
+}
+
+TEST(ConcurrentHashMapTest, Basic) {
+    ConcurrentHashMap<std::string, int> map{4};
+    EXPECT_EQ(map.shardCount(), 4);
+
+    EXPECT_TRUE(map.insert("a", 1));
+    EXPECT_FALSE(map.insert("a", 2));
+    EXPECT_EQ(map.get(std::string_view{"a"}), 1);
+    EXPECT_EQ(map.get("b"), std::nullopt);
+
+    EXPECT_FALSE(map.upsert("a", 10, [](int& v) { v += 5; }));
+    EXPECT_TRUE(map.upsert("b", 10, [](int& v) { v += 5; }));
+    EXPECT_EQ(map.get("a"), 6);
+    EXPECT_EQ(map.get("b"), 10);
+
+    EXPECT_EQ(map.computeIfAbsent("b", [] { return 0; }), 10);
+    EXPECT_EQ(map.computeIfAbsent("c", [] { return 3; }), 3);
+    EXPECT_EQ(map.size(), 3);
+
+    EXPECT_EQ(map.take("c"), 3);
+    EXPECT_FALSE(map.contains("c"));
+
+    map.retain([](const std::string& key, int&) { return key != "a"; });
+    EXPECT_EQ(map.size(), 1);
+
+    int sum = 0;
+    map.forEach([&](const std::string&, const int& value) { sum += value; });
+    EXPECT_EQ(sum, 10);
+}
+
+TEST(ConcurrentHashMapTest, Concurrent) {
+    ConcurrentHashMap<int, size_t> map;
+    std::atomic<size_t> computed{0};
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 1000; j++) {
+                map.upsert(j, 1, [](size_t& v) { v++; });
+
+                map.computeIfAbsent(-j - 1, [&] {
+                    computed.fetch_add(1, std::memory_order::relaxed);
+                    return static_cast<size_t>(j);
+                });
+            }
+        });
+    }
+
+    // iterating while the map is being written to
+    threads.emplace_back([&] {
+        for (size_t i = 0; i < 20; i++) {
+            map.forEach([](const int& key, const size_t& value) {
+                EXPECT_TRUE(key < 0 || (value >= 1 && value <= 4));
+            });
+        }
+    });
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(map.size(), 2000);
+    EXPECT_EQ(computed.load(), 1000);
+
+    for (int j = 0; j < 1000; j++) {
+        EXPECT_EQ(map.get(j), 4);
+        EXPECT_EQ(map.get(-j - 1), static_cast<size_t>(j));
+    }
+}
+
+TEST(ThreadLocalTest, Aggregate) {
+    ThreadLocal<std::atomic<size_t>> local;
+    EXPECT_EQ(local.get(), nullptr);
+
+    local.getOrDefault() += 5;
+    EXPECT_EQ(local.get(), &local.getOrDefault());
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 8; i++) {
+        threads.emplace_back([&] {
+            auto& value = local.getOrDefault();
+            for (size_t j = 0; j < 1000; j++) {
+                value.fetch_add(1, std::memory_order::relaxed);
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    // values of exited threads are kept around
+    size_t sum = 0, count = 0;
+    local.forEach([&](const std::atomic<size_t>& value) {
+        sum += value.load();
+        count++;
+    });
+
+    EXPECT_EQ(sum, 8005);
+    EXPECT_GE(count, 2);
+
+    local.clear();
+    EXPECT_EQ(local.get(), nullptr);
+}
+
+TEST(CondvarTest, ProducerConsumer) {
+    Mutex<std::deque<int>> queue;
+    Condvar cond;
+    std::atomic<int> sum{0};
+    std::vector<std::thread> consumers;
+
+    for (size_t i = 0; i < 4; i++) {
+        consumers.emplace_back([&] {
+            while (true) {
+                auto lock = queue.lock();
+                lock.wait(cond, [&] { return !lock->empty(); });
+
+                int value = lock->front();
+                lock->pop_front();
+                if (value < 0) break;
+
+                sum += value;
+            }
+        });
+    }
+
+    for (int i = 1; i <= 1000; i++) {
+        auto lock = queue.lock();
+        lock->push_back(i);
+        cond.notifyOne();
+    }
+
+    {
+        auto lock = queue.lock();
+        for (size_t i = 0; i < consumers.size(); i++) {
+            lock->push_back(-1);
+        }
+        cond.notifyAll();
+    }
+
+    for (auto& t : consumers) {
+        t.join();
+    }
+
+    EXPECT_EQ(sum, 500500);
+}
+
+TEST(CondvarTest, NotifyAllRequeues) {
+    Mutex<bool> ready{false};
+    Condvar cond;
+    std::atomic<size_t> woken{0};
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 8; i++) {
+        threads.emplace_back([&] {
+            auto lock = ready.lock();
+            lock.wait(cond, [&] { return *lock; });
+            woken++;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    {
+        // notified with the mutex held, so the waiters are moved to the mutex instead of being woken
+        auto lock = ready.lock();
+        lock = true;
+        cond.notifyAll();
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(woken, 8);
+}
+
+TEST(CondvarTest, Timeout) {
+    Mutex<> mtx;
+    Condvar cond;
+
+    auto lock = mtx.lock();
+    auto start = Instant::now();
+    EXPECT_FALSE(lock.wait(cond, [] { return false; }, Duration::fromMillis(10)));
+    EXPECT_GE(start.elapsed(), Duration::fromMillis(10));
+    EXPECT_FALSE(lock.wait(cond, Duration::fromMillis(1)));
+}